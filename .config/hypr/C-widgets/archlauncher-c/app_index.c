@@ -0,0 +1,349 @@
+#include "app_index.h"
+#include "app_info.h"
+#include "launch.h"
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// On-disk Format
+// -----------------------------------------------------------------------------
+//
+// header | dirs[n_dirs] | entries[n_entries] | string pool
+//
+// Entries are stored in the same order compare_apps() would sort them, so the
+// warm path never has to sort. All *_off fields are byte offsets into the
+// string pool, which holds NUL-terminated strings.
+
+#define APP_INDEX_MAGIC     0x58444e43u // "CNDX"
+#define APP_INDEX_VERSION   2
+#define APP_INDEX_NO_ICON   G_MAXUINT32
+#define APP_INDEX_NO_PATH   G_MAXUINT32
+#define APP_INDEX_MAX_DEPTH 4
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 n_dirs;
+    guint32 n_entries;
+    guint32 env_off;    // Locale, desktop and $PATH the entries were resolved for
+    guint32 pool_size;
+} AppIndexHeader;
+
+typedef struct {
+    gint64 mtime_sec;
+    gint64 mtime_nsec;
+    guint32 path_off;
+    guint32 is_root;    // TRUE for $XDG_DATA_DIRS/applications itself
+} AppIndexDir;
+
+typedef struct {
+    guint32 name_off;
+    guint32 exec_off;
+    guint32 icon_off;   // APP_INDEX_NO_ICON if the app has no icon
+    guint32 path_off;   // Resolved program, APP_INDEX_NO_PATH if not found
+} AppIndexEntry;
+
+// A directory and the mtime it had when the index was built
+typedef struct {
+    gchar *path;
+    gint64 mtime_sec;
+    gint64 mtime_nsec;
+    gboolean is_root;
+} DirStamp;
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static void dir_stamp_clear(gpointer data) {
+    DirStamp *stamp = data;
+    g_free(stamp->path);
+}
+
+static void stat_mtime(const gchar *path, gint64 *sec, gint64 *nsec) {
+    GStatBuf st;
+    if (g_stat(path, &st) == 0) {
+        *sec = st.st_mtim.tv_sec;
+        *nsec = st.st_mtim.tv_nsec;
+    } else {
+        // A missing directory is recorded too, so creating it later invalidates the index.
+        *sec = 0;
+        *nsec = 0;
+    }
+}
+
+// The applications directories GIO scans, in lookup order.
+static GPtrArray* get_root_dirs(void) {
+    GPtrArray *roots = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(roots, g_build_filename(g_get_user_data_dir(), "applications", NULL));
+    const gchar * const *system_dirs = g_get_system_data_dirs();
+    for (int i = 0; system_dirs[i] != NULL; i++) {
+        g_ptr_array_add(roots, g_build_filename(system_dirs[i], "applications", NULL));
+    }
+    return roots;
+}
+
+// Display names and OnlyShowIn/NotShowIn depend on these, and the resolved
+// program paths on $PATH, so they are all part of the key.
+static gchar* get_env_key(void) {
+    const gchar *desktop = g_getenv("XDG_CURRENT_DESKTOP");
+    const gchar *path_env = g_getenv("PATH");
+    return g_strdup_printf("%s;%s;%s", g_get_language_names()[0], desktop ? desktop : "",
+                           path_env ? path_env : "");
+}
+
+// Records the mtime of a directory and, recursively, of its subdirectories.
+static void collect_dir_stamps(GArray *stamps, const gchar *path, gboolean is_root, int depth) {
+    DirStamp stamp = { g_strdup(path), 0, 0, is_root };
+    stat_mtime(path, &stamp.mtime_sec, &stamp.mtime_nsec);
+    g_array_append_val(stamps, stamp);
+
+    if (depth >= APP_INDEX_MAX_DEPTH) return;
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (!dir) return;
+
+    const gchar *filename;
+    while ((filename = g_dir_read_name(dir))) {
+        gchar *child = g_build_filename(path, filename, NULL);
+        if (g_file_test(child, G_FILE_TEST_IS_DIR)) {
+            collect_dir_stamps(stamps, child, FALSE, depth + 1);
+        }
+        g_free(child);
+    }
+    g_dir_close(dir);
+}
+
+static guint32 pool_add(GString *pool, const gchar *str) {
+    guint32 off = pool->len;
+    g_string_append_len(pool, str, strlen(str) + 1);
+    return off;
+}
+
+// -----------------------------------------------------------------------------
+// Warm Path: Reading the Index
+// -----------------------------------------------------------------------------
+
+// TRUE if the mapped index is intact and still matches the filesystem.
+static gboolean app_index_is_current(const gchar *contents, gsize length) {
+    gboolean current = FALSE;
+    GPtrArray *roots = NULL;
+    gchar *env_key = NULL;
+
+    if (length < sizeof(AppIndexHeader)) goto out;
+    const AppIndexHeader *header = (const AppIndexHeader *)contents;
+    if (header->magic != APP_INDEX_MAGIC || header->version != APP_INDEX_VERSION) goto out;
+
+    guint64 dirs_size = (guint64)header->n_dirs * sizeof(AppIndexDir);
+    guint64 entries_size = (guint64)header->n_entries * sizeof(AppIndexEntry);
+    if (sizeof(AppIndexHeader) + dirs_size + entries_size + header->pool_size != length) goto out;
+    if (header->pool_size == 0) goto out;
+
+    const AppIndexDir *dirs = (const AppIndexDir *)(contents + sizeof(AppIndexHeader));
+    const AppIndexEntry *entries = (const AppIndexEntry *)((const gchar *)dirs + dirs_size);
+    const gchar *pool = (const gchar *)entries + entries_size;
+    if (pool[header->pool_size - 1] != '\0' || header->env_off >= header->pool_size) goto out;
+
+    env_key = get_env_key();
+    if (g_strcmp0(pool + header->env_off, env_key) != 0) goto out;
+
+    // The set of applications directories must be the same, in the same order...
+    roots = get_root_dirs();
+    guint root_index = 0;
+    for (guint32 i = 0; i < header->n_dirs; i++) {
+        if (dirs[i].path_off >= header->pool_size) goto out;
+        const gchar *path = pool + dirs[i].path_off;
+        if (dirs[i].is_root) {
+            if (root_index >= roots->len || g_strcmp0(path, g_ptr_array_index(roots, root_index)) != 0) goto out;
+            root_index++;
+        }
+        // ...and none of them may have gained, lost or renamed an entry since.
+        gint64 sec, nsec;
+        stat_mtime(path, &sec, &nsec);
+        if (sec != dirs[i].mtime_sec || nsec != dirs[i].mtime_nsec) goto out;
+    }
+    if (root_index != roots->len) goto out;
+
+    for (guint32 i = 0; i < header->n_entries; i++) {
+        if (entries[i].name_off >= header->pool_size || entries[i].exec_off >= header->pool_size) goto out;
+        if (entries[i].icon_off != APP_INDEX_NO_ICON && entries[i].icon_off >= header->pool_size) goto out;
+        if (entries[i].path_off != APP_INDEX_NO_PATH && entries[i].path_off >= header->pool_size) goto out;
+    }
+    current = TRUE;
+
+out:
+    if (roots) g_ptr_array_unref(roots);
+    g_free(env_key);
+    return current;
+}
+
+// Maps the index and, if it is intact and still matches the filesystem, turns it
+// into an AppInfo list. Returns FALSE if the index must be rebuilt.
+static gboolean app_index_read(const gchar *index_path, gboolean no_icons, GSList **out_apps) {
+    GMappedFile *mapped = g_mapped_file_new(index_path, FALSE, NULL);
+    if (!mapped) return FALSE;
+
+    const gchar *contents = g_mapped_file_get_contents(mapped);
+    if (!app_index_is_current(contents, g_mapped_file_get_length(mapped))) {
+        g_mapped_file_unref(mapped);
+        return FALSE;
+    }
+
+    const AppIndexHeader *header = (const AppIndexHeader *)contents;
+    const AppIndexEntry *entries = (const AppIndexEntry *)(contents + sizeof(AppIndexHeader) +
+                                                           (gsize)header->n_dirs * sizeof(AppIndexDir));
+    const gchar *pool = (const gchar *)entries + (gsize)header->n_entries * sizeof(AppIndexEntry);
+
+    // Prepend back-to-front so the list comes out in the stored (sorted) order.
+    GSList *apps = NULL;
+    for (guint32 i = header->n_entries; i > 0; i--) {
+        const AppIndexEntry *entry = &entries[i - 1];
+        GIcon *icon = NULL;
+        if (!no_icons && entry->icon_off != APP_INDEX_NO_ICON) {
+            icon = g_icon_new_for_string(pool + entry->icon_off, NULL);
+        }
+        AppInfo *app = app_info_new(pool + entry->name_off, pool + entry->exec_off, icon);
+        if (entry->path_off != APP_INDEX_NO_PATH) {
+            app->path = g_strdup(pool + entry->path_off);
+        }
+        apps = g_slist_prepend(apps, app);
+        if (icon) {
+            g_object_unref(icon);
+        }
+    }
+    *out_apps = apps;
+    g_mapped_file_unref(mapped);
+    return TRUE;
+}
+
+// -----------------------------------------------------------------------------
+// Cold Path: Scanning .desktop Files and Writing the Index
+// -----------------------------------------------------------------------------
+
+// Scans for and returns a sorted list of all .desktop applications, with icons.
+static GSList* scan_applications(void) {
+    GSList *apps = NULL;
+    GList *app_infos = g_app_info_get_all();
+
+    for (GList *l = app_infos; l != NULL; l = l->next) {
+        GAppInfo *app_info = G_APP_INFO(l->data);
+        if (g_app_info_should_show(app_info)) {
+            const gchar *name = g_app_info_get_display_name(app_info);
+            const gchar *exec = g_app_info_get_commandline(app_info);
+            if (!name || !exec) {
+                continue;
+            }
+            AppInfo *app = app_info_new(name, exec, g_app_info_get_icon(app_info));
+            // Resolved once here so that launching never searches $PATH.
+            app->path = launch_resolve_program(exec);
+            apps = g_slist_prepend(apps, app);
+        }
+    }
+    g_list_free_full(app_infos, g_object_unref);
+    return g_slist_sort(apps, compare_apps);
+}
+
+static void write_index(const gchar *index_path, GArray *stamps, GSList *apps) {
+    GString *pool = g_string_new(NULL);
+    GArray *dirs = g_array_sized_new(FALSE, FALSE, sizeof(AppIndexDir), stamps->len);
+    GArray *entries = g_array_new(FALSE, FALSE, sizeof(AppIndexEntry));
+
+    gchar *env_key = get_env_key();
+    guint32 env_off = pool_add(pool, env_key);
+    g_free(env_key);
+
+    for (guint i = 0; i < stamps->len; i++) {
+        DirStamp *stamp = &g_array_index(stamps, DirStamp, i);
+        AppIndexDir dir = { stamp->mtime_sec, stamp->mtime_nsec, pool_add(pool, stamp->path), stamp->is_root };
+        g_array_append_val(dirs, dir);
+    }
+
+    for (GSList *l = apps; l != NULL; l = l->next) {
+        AppInfo *app = l->data;
+        AppIndexEntry entry = { pool_add(pool, app->name), pool_add(pool, app->exec),
+                                APP_INDEX_NO_ICON, APP_INDEX_NO_PATH };
+        if (app->path) {
+            entry.path_off = pool_add(pool, app->path);
+        }
+        // Not every GIcon can be serialized (e.g. in-memory icons); those are simply dropped.
+        gchar *icon_str = app->icon ? g_icon_to_string(app->icon) : NULL;
+        if (icon_str) {
+            entry.icon_off = pool_add(pool, icon_str);
+            g_free(icon_str);
+        }
+        g_array_append_val(entries, entry);
+    }
+
+    AppIndexHeader header = { APP_INDEX_MAGIC, APP_INDEX_VERSION, dirs->len, entries->len, env_off, pool->len };
+    GByteArray *buffer = g_byte_array_new();
+    g_byte_array_append(buffer, (const guint8 *)&header, sizeof(header));
+    g_byte_array_append(buffer, (const guint8 *)dirs->data, dirs->len * sizeof(AppIndexDir));
+    g_byte_array_append(buffer, (const guint8 *)entries->data, entries->len * sizeof(AppIndexEntry));
+    g_byte_array_append(buffer, (const guint8 *)pool->str, pool->len);
+
+    // g_file_set_contents() writes to a temporary file and renames it into place,
+    // so a concurrently starting launcher never maps a half-written index.
+    GError *error = NULL;
+    if (!g_file_set_contents(index_path, (const gchar *)buffer->data, buffer->len, &error)) {
+        g_warning("Failed to write DRUN index: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_byte_array_unref(buffer);
+    g_array_unref(entries);
+    g_array_unref(dirs);
+    g_string_free(pool, TRUE);
+}
+
+static GSList* app_index_rebuild(const gchar *index_path) {
+    // Stamp the directories *before* scanning, so a change that races with the
+    // scan is picked up by the next start instead of being lost.
+    GArray *stamps = g_array_new(FALSE, FALSE, sizeof(DirStamp));
+    g_array_set_clear_func(stamps, dir_stamp_clear);
+    GPtrArray *roots = get_root_dirs();
+    for (guint i = 0; i < roots->len; i++) {
+        collect_dir_stamps(stamps, g_ptr_array_index(roots, i), TRUE, 0);
+    }
+    g_ptr_array_unref(roots);
+
+    GSList *apps = scan_applications();
+    write_index(index_path, stamps, apps);
+    g_array_unref(stamps);
+    return apps;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+gboolean app_index_is_stale(void) {
+    gchar *index_path = launcher_cache_path(APP_INDEX_FILE);
+    GMappedFile *mapped = g_mapped_file_new(index_path, FALSE, NULL);
+    g_free(index_path);
+    if (!mapped) return TRUE;
+    gboolean current = app_index_is_current(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped));
+    g_mapped_file_unref(mapped);
+    return !current;
+}
+
+GSList* app_index_load(gboolean no_icons, gboolean force_rebuild) {
+    gchar *index_path = launcher_cache_path(APP_INDEX_FILE);
+    GSList *apps = NULL;
+
+    if (!force_rebuild && app_index_read(index_path, no_icons, &apps)) {
+        g_debug("Read DRUN index from: %s", index_path);
+        g_free(index_path);
+        return apps;
+    }
+
+    g_debug("Rebuilding DRUN index at: %s", index_path);
+    apps = app_index_rebuild(index_path);
+    if (no_icons) {
+        for (GSList *l = apps; l != NULL; l = l->next) {
+            AppInfo *app = l->data;
+            g_clear_object(&app->icon);
+        }
+    }
+    g_free(index_path);
+    return apps;
+}
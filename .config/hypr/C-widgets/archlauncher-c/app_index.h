@@ -0,0 +1,21 @@
+#ifndef APP_INDEX_H
+#define APP_INDEX_H
+
+#include <glib.h>
+
+// Name of the binary drun index inside ~/.cache/cachy/
+#define APP_INDEX_FILE "drun_index.bin"
+
+// Returns the alphabetically sorted list of desktop applications as AppInfo
+// structs. The list is read from a memory-mapped index in the cache directory
+// and only rebuilt from the .desktop files when one of the applications
+// directories changed (or when force_rebuild is set).
+// Free the result with g_slist_free_full(list, free_app_info).
+GSList* app_index_load(gboolean no_icons, gboolean force_rebuild);
+
+// TRUE if the index is missing or one of the applications directories changed
+// since it was written, i.e. if app_index_load() would rebuild it. Only stats
+// the directories; no .desktop file is read.
+gboolean app_index_is_stale(void);
+
+#endif // APP_INDEX_H
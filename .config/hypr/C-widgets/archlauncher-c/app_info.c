@@ -0,0 +1,119 @@
+#include "app_info.h"
+#include "fuzzy.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+AppInfo* app_info_new(const char *name, const char *exec, GIcon *icon) {
+    AppInfo *app = g_new(AppInfo, 1);
+    app->name = g_strdup(name);
+    app->exec = g_strdup(exec);
+    app->path = NULL;
+    app->icon = icon ? g_object_ref(icon) : NULL;
+    app->key = search_key_new(name);
+    app->key_aligned = strlen(app->key) == strlen(name);
+    app->char_mask = fuzzy_char_mask(app->key);
+    return app;
+}
+
+gchar* search_key_new(const char *text) {
+    gboolean ascii = TRUE;
+    for (const guchar *p = (const guchar *)text; *p; p++) {
+        if (*p >= 0x80) {
+            ascii = FALSE;
+            break;
+        }
+    }
+    // Most names are ASCII, so they skip the much slower Unicode tables.
+    if (ascii || !g_utf8_validate(text, -1, NULL)) {
+        return g_ascii_strdown(text, -1);
+    }
+    gchar *normalized = g_utf8_normalize(text, -1, G_NORMALIZE_DEFAULT_COMPOSE);
+    gchar *key = g_utf8_casefold(normalized, -1);
+    g_free(normalized);
+    return key;
+}
+
+void free_app_info(gpointer data) {
+    AppInfo *app = (AppInfo *)data;
+    g_free(app->name);
+    g_free(app->exec);
+    g_free(app->path);
+    g_free(app->key);
+    if (app->icon) {
+        g_object_unref(app->icon);
+    }
+    g_free(app);
+}
+
+// Entries per block of AppInfo, and bytes per block of strings
+#define ARENA_BLOCK_APPS 4096
+#define ARENA_BLOCK_BYTES (256 * 1024)
+
+struct _AppArena {
+    GPtrArray *blocks;   // Arrays of ARENA_BLOCK_APPS AppInfo, so entries never move
+    guint block_used;    // Entries taken from the last block
+    GStringChunk *strings;
+    GHashTable *icons;   // Every icon handed out, holding one reference each
+    GPtrArray *apps;
+};
+
+AppArena* app_arena_new(void) {
+    AppArena *arena = g_new0(AppArena, 1);
+    arena->blocks = g_ptr_array_new_with_free_func(g_free);
+    arena->block_used = ARENA_BLOCK_APPS;
+    arena->strings = g_string_chunk_new(ARENA_BLOCK_BYTES);
+    arena->icons = g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, NULL);
+    arena->apps = g_ptr_array_new();
+    return arena;
+}
+
+AppInfo* app_arena_add(AppArena *arena, const char *name, gsize length, GIcon *icon) {
+    if (arena->block_used == ARENA_BLOCK_APPS) {
+        g_ptr_array_add(arena->blocks, g_new(AppInfo, ARENA_BLOCK_APPS));
+        arena->block_used = 0;
+    }
+    AppInfo *block = g_ptr_array_index(arena->blocks, arena->blocks->len - 1);
+    AppInfo *app = &block[arena->block_used++];
+
+    app->name = g_string_chunk_insert_len(arena->strings, name, length);
+    app->exec = app->name;
+    app->path = NULL;
+    if (icon && !g_hash_table_contains(arena->icons, icon)) {
+        g_hash_table_add(arena->icons, g_object_ref(icon));
+    }
+    app->icon = icon;
+    gchar *key = search_key_new(app->name);
+    app->key_aligned = strlen(key) == length;
+    app->key = strcmp(key, app->name) == 0 ? app->name : g_string_chunk_insert(arena->strings, key);
+    g_free(key);
+    app->char_mask = fuzzy_char_mask(app->key);
+    g_ptr_array_add(arena->apps, app);
+    return app;
+}
+
+GPtrArray* app_arena_get_apps(AppArena *arena) {
+    return arena->apps;
+}
+
+void app_arena_free(AppArena *arena) {
+    if (!arena) return;
+    g_ptr_array_unref(arena->apps);
+    g_hash_table_destroy(arena->icons);
+    g_string_chunk_free(arena->strings);
+    g_ptr_array_unref(arena->blocks);
+    g_free(arena);
+}
+
+gint compare_apps(gconstpointer a, gconstpointer b) {
+    AppInfo *app_a = (AppInfo *)a;
+    AppInfo *app_b = (AppInfo *)b;
+    return g_strcmp0(app_a->name, app_b->name);
+}
+
+gchar* launcher_cache_path(const char *file_name) {
+    gchar *cache_dir = g_build_filename(g_get_user_cache_dir(), CACHE_DIR_NAME, NULL);
+    g_mkdir_with_parents(cache_dir, 0755);
+    gchar *path = g_build_filename(cache_dir, file_name, NULL);
+    g_free(cache_dir);
+    return path;
+}
@@ -0,0 +1,54 @@
+#ifndef APP_INFO_H
+#define APP_INFO_H
+
+#include <gio/gio.h>
+
+// Subdirectory of $XDG_CACHE_HOME shared by all launcher caches
+#define CACHE_DIR_NAME "cachy"
+
+// A struct to hold our simplified application info
+typedef struct {
+    char *name;
+    char *exec;
+    char *path;          // Absolute path of the program exec runs, NULL if unknown
+    GIcon *icon;
+    char *key;           // Casefolded, normalized name the matcher runs on
+    gboolean key_aligned; // TRUE if byte offsets in key are byte offsets in name
+    guint64 char_mask;   // fuzzy_char_mask() of key, for the matcher's prefilter
+} AppInfo;
+
+// Allocates a new AppInfo, copying the given strings. The icon is ref'd if set.
+AppInfo* app_info_new(const char *name, const char *exec, GIcon *icon);
+
+// Returns the search key for text: NFC-normalized and casefolded, or just
+// ASCII-lowercased for pure ASCII (and non-UTF-8) input. Free with g_free().
+gchar* search_key_new(const char *text);
+
+// Frees the memory associated with an AppInfo struct
+void free_app_info(gpointer data);
+
+// A block of AppInfo allocated together with their strings, for providers
+// with far too many entries to allocate one by one. An entry's name and exec
+// are the same string, and so is its key unless folding changes the name.
+// The entries are freed all at once with the arena, never with free_app_info().
+typedef struct _AppArena AppArena;
+
+AppArena* app_arena_new(void);
+
+// Appends an entry named (and running) the first length bytes of name. The
+// arena keeps one reference to every distinct icon passed in.
+AppInfo* app_arena_add(AppArena *arena, const char *name, gsize length, GIcon *icon);
+
+// The entries in the order they were added. The array belongs to the arena.
+GPtrArray* app_arena_get_apps(AppArena *arena);
+
+void app_arena_free(AppArena *arena);
+
+// Comparison function for sorting AppInfo structs alphabetically by name
+gint compare_apps(gconstpointer a, gconstpointer b);
+
+// Returns ~/.cache/cachy/<file_name>, creating the cache directory if needed.
+// The caller is responsible for freeing the returned string with g_free().
+gchar* launcher_cache_path(const char *file_name);
+
+#endif // APP_INFO_H
@@ -0,0 +1,417 @@
+#include "catalog.h"
+#include "history.h"
+#include <string.h>
+
+#define MAX_PROVIDERS 4
+
+// The providers each mode merges, NULL-terminated
+static const Provider *const mode_providers[][MAX_PROVIDERS] = {
+    [MODE_DRUN] = { &desktop_provider, NULL },
+    [MODE_RUN]  = { &path_provider, &history_provider, NULL },
+    [MODE_WINDOWS] = { &window_provider, NULL },
+    [MODE_FILES] = { &file_provider, NULL },
+    [MODE_EMOJI] = { &emoji_provider, NULL },
+};
+
+static const gchar *mode_names[] = {
+    [MODE_DRUN] = "drun",
+    [MODE_RUN] = "run",
+    [MODE_WINDOWS] = "windows",
+    [MODE_FILES] = "files",
+    [MODE_EMOJI] = "emoji",
+};
+
+// One provider being loaded on its worker thread
+typedef struct {
+    Catalog *catalog;
+    const Provider *provider;
+    gboolean no_icons;
+    gboolean rebuild_cache;
+    CatalogSegment *segment;  // Built by the thread, NULL if the provider had no entries
+} LoadJob;
+
+static Catalog* catalog_ref(Catalog *catalog) {
+    catalog->ref_count++;
+    return catalog;
+}
+
+static void catalog_unref(Catalog *catalog) {
+    if (--catalog->ref_count > 0) return;
+    g_free(catalog);
+}
+
+static void catalog_segment_free(CatalogSegment *segment) {
+    filter_worker_free(segment->filter_worker);
+    filter_result_free(segment->result);
+    search_index_free(segment->search_index);
+    g_ptr_array_unref(segment->app_array);
+    frecency_store_free(segment->frecency);
+    g_free(segment->frecency_scores);
+    g_slist_free_full(segment->apps, free_app_info);
+    app_arena_free(segment->arena);
+    g_free(segment);
+}
+
+// -----------------------------------------------------------------------------
+// Merging
+// -----------------------------------------------------------------------------
+
+// The worker's order, over catalog ids: best score first, then the more
+// frecent entry, then provider arrival and list (alphabetical) order.
+static gint compare_merged(const FilterMatch *a, const FilterMatch *b, const gdouble *frecency) {
+    if (a->score != b->score) {
+        return a->score > b->score ? -1 : 1;
+    }
+    if (frecency[a->id] != frecency[b->id]) {
+        return frecency[a->id] > frecency[b->id] ? -1 : 1;
+    }
+    return a->id < b->id ? -1 : (a->id > b->id);
+}
+
+// Merges the sorted matches of segment (local ids) into the sorted matches so
+// far (catalog ids). Linear, so a late provider costs no resort of the others.
+static GArray* merge_segment(GArray *merged, CatalogSegment *segment, const gdouble *frecency) {
+    GArray *theirs = segment->result->matches;
+    GArray *out = g_array_sized_new(FALSE, FALSE, sizeof(FilterMatch), merged->len + theirs->len);
+    guint i = 0;
+    guint j = 0;
+    while (i < merged->len || j < theirs->len) {
+        FilterMatch next;
+        if (j < theirs->len) {
+            next = g_array_index(theirs, FilterMatch, j);
+            next.id += segment->offset;
+        }
+        if (j >= theirs->len ||
+            (i < merged->len && compare_merged(&g_array_index(merged, FilterMatch, i), &next, frecency) <= 0)) {
+            g_array_append_val(out, g_array_index(merged, FilterMatch, i));
+            i++;
+        } else {
+            g_array_append_val(out, next);
+            j++;
+        }
+    }
+    g_array_unref(merged);
+    return out;
+}
+
+// Hands the owner the merge of every answer to the current query so far.
+static void deliver_merged(Catalog *catalog) {
+    FilterResult *merged = g_new(FilterResult, 1);
+    merged->generation = catalog->generation;
+    gchar *key = search_key_new(catalog->query);
+    fuzzy_query_init(&merged->query, key);
+    g_free(key);
+    merged->matches = g_array_new(FALSE, FALSE, sizeof(FilterMatch));
+    const gdouble *frecency = (const gdouble *)catalog->frecency_scores->data;
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        if (!segment->result) continue;
+        merged->matches = merge_segment(merged->matches, segment, frecency);
+    }
+
+    // The complete empty query result is what showing the catalog starts from.
+    if (catalog->query[0] == '\0' && catalog_is_settled(catalog)) {
+        if (catalog->default_ids) g_array_unref(catalog->default_ids);
+        catalog->default_ids = g_array_sized_new(FALSE, FALSE, sizeof(guint32), merged->matches->len);
+        for (guint i = 0; i < merged->matches->len; i++) {
+            g_array_append_val(catalog->default_ids, g_array_index(merged->matches, FilterMatch, i).id);
+        }
+    }
+    catalog->callback(merged, catalog);
+}
+
+static void on_segment_result(FilterResult *result, gpointer user_data) {
+    CatalogSegment *segment = user_data;
+    Catalog *catalog = segment->catalog;
+    if (result->generation != segment->generation) {
+        filter_result_free(result);
+        return;
+    }
+    g_debug("Provider %s: %u matches for \"%s\" after %.2f ms", segment->provider->name, result->matches->len,
+            catalog->query, (g_get_monotonic_time() - segment->submit_time) / 1000.0);
+    filter_result_free(segment->result);
+    segment->result = result;
+    deliver_merged(catalog);
+}
+
+static void submit_to_segment(Catalog *catalog, CatalogSegment *segment) {
+    filter_result_free(segment->result);
+    segment->result = NULL;
+    segment->submit_time = g_get_monotonic_time();
+    segment->generation = filter_worker_submit(segment->filter_worker, catalog->query);
+}
+
+// -----------------------------------------------------------------------------
+// Loading Providers
+// -----------------------------------------------------------------------------
+
+// Adds a loaded segment to the catalog and runs the current query over it.
+static gboolean deliver_segment(gpointer user_data) {
+    LoadJob *job = user_data;
+    Catalog *catalog = job->catalog;
+    CatalogSegment *segment = job->segment;
+    catalog->n_pending--;
+
+    if (catalog->closed) {
+        if (segment) catalog_segment_free(segment);
+    } else {
+        if (segment) {
+            segment->catalog = catalog;
+            segment->offset = catalog->app_array->len;
+            segment->load_ms = (g_get_monotonic_time() - catalog->load_start) / 1000.0;
+            for (guint i = 0; i < segment->app_array->len; i++) {
+                g_ptr_array_add(catalog->app_array, g_ptr_array_index(segment->app_array, i));
+            }
+            g_array_append_vals(catalog->frecency_scores, segment->frecency_scores, segment->app_array->len);
+            segment->filter_worker = filter_worker_new(segment->app_array, segment->search_index,
+                                                       segment->frecency_scores, on_segment_result, segment);
+            g_ptr_array_add(catalog->segments, segment);
+            g_debug("Provider %s: %u entries on the main loop after %.2f ms", job->provider->name,
+                    segment->app_array->len, segment->load_ms);
+            submit_to_segment(catalog, segment);
+        }
+        if (catalog->progress) catalog->progress(catalog);
+    }
+
+    catalog_unref(catalog);
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+// Loads one provider and builds everything searching it needs, off the main thread.
+static gpointer load_thread_func(gpointer user_data) {
+    LoadJob *job = user_data;
+    gint64 start = g_get_monotonic_time();
+    GSList *apps = NULL;
+    AppArena *arena = NULL;
+    GPtrArray *app_array = NULL;
+    if (job->provider->load_arena) {
+        arena = job->provider->load_arena(job->no_icons, job->rebuild_cache);
+        if (arena) app_array = g_ptr_array_ref(app_arena_get_apps(arena));
+    } else {
+        apps = job->provider->load(job->no_icons, job->rebuild_cache);
+        if (apps) {
+            app_array = g_ptr_array_new();
+            for (GSList *l = apps; l != NULL; l = l->next) {
+                g_ptr_array_add(app_array, l->data);
+            }
+        }
+    }
+
+    if (app_array) {
+        CatalogSegment *segment = g_new0(CatalogSegment, 1);
+        segment->provider = job->provider;
+        segment->apps = apps;
+        segment->arena = arena;
+        segment->app_array = app_array;
+        segment->search_index = search_index_new(app_array);
+
+        // Apps are keyed by their command line, which also identifies run mode entries.
+        segment->frecency_scores = g_new0(gdouble, segment->app_array->len);
+        if (job->provider->frecency_file) {
+            segment->frecency = frecency_store_load(job->provider->frecency_file);
+            for (guint32 i = 0; i < segment->app_array->len; i++) {
+                AppInfo *app = g_ptr_array_index(segment->app_array, i);
+                segment->frecency_scores[i] = frecency_store_score(segment->frecency, app->exec);
+            }
+        }
+        job->segment = segment;
+    }
+
+    g_debug("Provider %s: loaded in %.2f ms", job->provider->name, (g_get_monotonic_time() - start) / 1000.0);
+    g_idle_add(deliver_segment, job);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+const gchar* launcher_mode_to_string(LauncherMode mode) {
+    return mode_names[mode];
+}
+
+LauncherMode launcher_mode_from_string(const gchar *name) {
+    for (gint mode = 0; mode < N_MODES; mode++) {
+        if (g_strcmp0(name, mode_names[mode]) == 0) return mode;
+    }
+    return MODE_DRUN;
+}
+
+Catalog* catalog_load(LauncherMode mode, gboolean no_icons, gboolean rebuild_cache,
+                      FilterResultCallback callback, CatalogProgressFunc progress, gpointer owner) {
+    Catalog *catalog = g_new0(Catalog, 1);
+    catalog->ref_count = 1;
+    catalog->owner = owner;
+    catalog->mode = mode;
+    catalog->callback = callback;
+    catalog->progress = progress;
+    catalog->app_array = g_ptr_array_new();
+    catalog->frecency_scores = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    catalog->segments = g_ptr_array_new();
+    catalog->query = g_strdup("");
+    catalog->load_start = g_get_monotonic_time();
+
+    for (gint i = 0; mode_providers[mode][i] != NULL; i++) {
+        LoadJob *job = g_new0(LoadJob, 1);
+        job->catalog = catalog_ref(catalog);
+        job->provider = mode_providers[mode][i];
+        job->no_icons = no_icons;
+        job->rebuild_cache = rebuild_cache;
+        catalog->n_pending++;
+        g_thread_unref(g_thread_new("launcher-provider", load_thread_func, job));
+    }
+    return catalog;
+}
+
+guint catalog_submit(Catalog *catalog, const gchar *text) {
+    g_free(catalog->query);
+    catalog->query = g_strdup(text);
+    catalog->generation++;
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        submit_to_segment(catalog, g_ptr_array_index(catalog->segments, i));
+    }
+    return catalog->generation;
+}
+
+gboolean catalog_is_settled(Catalog *catalog) {
+    if (catalog->n_pending > 0) return FALSE;
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        if (!segment->result) return FALSE;
+    }
+    return TRUE;
+}
+
+CatalogSegment* catalog_get_segment(Catalog *catalog, guint32 id) {
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        if (id >= segment->offset && id - segment->offset < segment->app_array->len) {
+            return segment;
+        }
+    }
+    return NULL;
+}
+
+GArray* catalog_get_most_frecent(Catalog *catalog, guint n) {
+    GArray *ids = g_array_sized_new(FALSE, FALSE, sizeof(guint32), n + 1);
+    const gdouble *scores = (const gdouble *)catalog->frecency_scores->data;
+    for (guint32 id = 0; id < catalog->frecency_scores->len; id++) {
+        if (scores[id] <= 0) continue;
+        // n is tiny, so an insertion into the sorted few beats any heap.
+        guint position = ids->len;
+        while (position > 0 && scores[g_array_index(ids, guint32, position - 1)] < scores[id]) {
+            position--;
+        }
+        if (position < n) {
+            g_array_insert_val(ids, position, id);
+            if (ids->len > n) g_array_set_size(ids, n);
+        }
+    }
+    return ids;
+}
+
+// Brings the launch history scores of segment up to date after its store
+// recorded a launch of local id (G_MAXUINT32 for none), and reruns the current
+// query over it so the ranking follows. Only entries with a score already, and
+// the one launched, are looked up again: the rest stay 0 until a reload.
+static void refresh_frecency(Catalog *catalog, CatalogSegment *segment, guint32 id) {
+    // The worker reads the scores while it ranks, so it is replaced instead
+    // of having them change under it.
+    filter_worker_free(segment->filter_worker);
+    gdouble *scores = segment->frecency_scores;
+    for (guint32 i = 0; i < segment->app_array->len; i++) {
+        if (scores[i] == 0 && i != id) continue;
+        AppInfo *app = g_ptr_array_index(segment->app_array, i);
+        scores[i] = frecency_store_score(segment->frecency, app->exec);
+    }
+    memcpy(&g_array_index(catalog->frecency_scores, gdouble, segment->offset), scores,
+           segment->app_array->len * sizeof(gdouble));
+    segment->filter_worker = filter_worker_new(segment->app_array, segment->search_index,
+                                               segment->frecency_scores, on_segment_result, segment);
+    submit_to_segment(catalog, segment);
+}
+
+void catalog_record_launch(Catalog *catalog, guint32 id) {
+    CatalogSegment *segment = catalog_get_segment(catalog, id);
+    if (!segment || !segment->frecency) return;
+    AppInfo *app = g_ptr_array_index(segment->app_array, id - segment->offset);
+    frecency_store_add(segment->frecency, app->exec);
+    refresh_frecency(catalog, segment, id - segment->offset);
+}
+
+// Returns the first position in segment whose name does not sort before prefix.
+static guint segment_lower_bound(CatalogSegment *segment, const gchar *prefix) {
+    guint low = 0;
+    guint high = segment->app_array->len;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        AppInfo *app = g_ptr_array_index(segment->app_array, mid);
+        if (strcmp(app->name, prefix) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+gchar* catalog_complete(Catalog *catalog, const gchar *prefix) {
+    if (prefix[0] == '\0') return NULL;
+    const gchar *best = NULL;
+    gdouble best_score = -1;
+    gsize prefix_len = strlen(prefix);
+
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        if (segment->provider->keep_order) continue;
+        // Every other segment is sorted by name, so the names starting with prefix
+        // are one run that a binary search finds.
+        for (guint j = segment_lower_bound(segment, prefix); j < segment->app_array->len; j++) {
+            AppInfo *app = g_ptr_array_index(segment->app_array, j);
+            if (strncmp(app->name, prefix, prefix_len) != 0) break;
+            if (app->name[prefix_len] == '\0') continue;
+            if (segment->frecency_scores[j] > best_score) {
+                best = app->name;
+                best_score = segment->frecency_scores[j];
+            }
+        }
+    }
+    return g_strdup(best);
+}
+
+void catalog_record_command(Catalog *catalog, const gchar *line) {
+    history_add(line);
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        if (segment->provider == &history_provider) {
+            frecency_store_add(segment->frecency, line);
+            // The history is short; a line run before is found by a scan.
+            guint32 id = G_MAXUINT32;
+            for (guint32 j = 0; j < segment->app_array->len && id == G_MAXUINT32; j++) {
+                AppInfo *app = g_ptr_array_index(segment->app_array, j);
+                if (g_strcmp0(app->exec, line) == 0) id = j;
+            }
+            refresh_frecency(catalog, segment, id);
+            return;
+        }
+    }
+    // The first command run makes the history; there is no segment for it yet.
+    FrecencyStore *frecency = frecency_store_load(FRECENCY_HISTORY_FILE);
+    frecency_store_add(frecency, line);
+    frecency_store_free(frecency);
+}
+
+void catalog_free(Catalog *catalog) {
+    if (!catalog) return;
+    catalog->closed = TRUE;
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        catalog_segment_free(g_ptr_array_index(catalog->segments, i));
+    }
+    g_ptr_array_unref(catalog->segments);
+    g_ptr_array_unref(catalog->app_array);
+    g_array_unref(catalog->frecency_scores);
+    if (catalog->default_ids) g_array_unref(catalog->default_ids);
+    g_free(catalog->query);
+    catalog_unref(catalog);
+}
@@ -0,0 +1,115 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <glib.h>
+#include "app_info.h"
+#include "filter_worker.h"
+#include "frecency.h"
+#include "provider.h"
+#include "search_index.h"
+
+// The mode of operation (application launcher or command runner)
+typedef enum {
+    MODE_DRUN,
+    MODE_RUN,
+    MODE_WINDOWS,
+    MODE_FILES,
+    MODE_EMOJI,
+    N_MODES
+} LauncherMode;
+
+// "drun", "run", "windows", "files" or "emoji", as on the command line
+const gchar* launcher_mode_to_string(LauncherMode mode);
+
+// The mode named name; anything unknown is MODE_DRUN.
+LauncherMode launcher_mode_from_string(const gchar *name);
+
+// The entries of one provider, loaded on its own thread. Its ids are local:
+// entry i of the segment is entry offset + i of the catalog.
+typedef struct {
+    const Provider *provider;
+    gpointer catalog;           // The Catalog the segment belongs to
+    guint32 offset;
+    GSList *apps;               // Owns the entries, unless the provider loads into an arena
+    AppArena *arena;            // Owns the entries of a provider with load_arena
+    GPtrArray *app_array;
+    SearchIndex *search_index;
+    FrecencyStore *frecency;    // Launch history of the provider, NULL if it keeps none
+    gdouble *frecency_scores;   // Launch history score of each app (0 without one), indexed by local id
+    FilterWorker *filter_worker;
+    gdouble load_ms;            // From catalog_load() until the entries reached the main loop
+
+    guint generation;           // The worker's generation of the catalog's current query
+    gint64 submit_time;         // When the current query was handed to the worker
+    FilterResult *result;       // The worker's answer to the current query, if it came yet
+} CatalogSegment;
+
+typedef struct _Catalog Catalog;
+
+// Called on the main loop every time a provider's entries arrive.
+typedef void (*CatalogProgressFunc)(Catalog *catalog);
+
+// Everything loaded for one mode: the entries of all its providers and what
+// searching and ranking them needs. Nothing in here touches GTK, so it can be
+// driven headlessly.
+struct _Catalog {
+    gpointer owner;           // Whatever loaded the catalog, for the callbacks
+    LauncherMode mode;
+    GPtrArray *app_array;     // The AppInfo of every segment, indexed by catalog id; only grows
+    GArray *frecency_scores;  // gdouble per catalog id
+    GPtrArray *segments;      // CatalogSegment, in order of arrival
+    guint n_pending;          // Providers still loading
+
+    gchar *query;             // The current query
+    guint generation;         // Bumped by every catalog_submit()
+    GArray *default_ids;      // Merged result of the empty query once complete, else NULL
+
+    FilterResultCallback callback;
+    CatalogProgressFunc progress;
+    gint64 load_start;
+    gint ref_count;
+    gboolean closed;
+};
+
+// Starts loading the providers of mode, each on a thread of its own, and
+// returns at once. As the providers arrive their entries are appended to
+// app_array, progress runs, and the current query is rerun over them.
+// callback receives the merged, ranked result of the current query every time
+// another provider answers it, with the catalog as user data; the result's
+// generation is the catalog's and its ids index app_array.
+Catalog* catalog_load(LauncherMode mode, gboolean no_icons, gboolean rebuild_cache,
+                      FilterResultCallback callback, CatalogProgressFunc progress, gpointer owner);
+
+// Makes text the current query and hands it to every loaded provider. Returns
+// the catalog's generation for it.
+guint catalog_submit(Catalog *catalog, const gchar *text);
+
+// TRUE once every provider has loaded and answered the current query.
+gboolean catalog_is_settled(Catalog *catalog);
+
+// The segment holding catalog id, or NULL if there is none.
+CatalogSegment* catalog_get_segment(Catalog *catalog, guint32 id);
+
+// Records a launch of the entry with catalog id in its provider's history and
+// reranks the provider's entries for the current query to match.
+void catalog_record_launch(Catalog *catalog, guint32 id);
+
+// Returns the ids of the (at most n) entries with the highest launch history
+// score, best first. Entries never launched are left out. Free with g_array_unref().
+GArray* catalog_get_most_frecent(Catalog *catalog, guint n);
+
+// Returns the name that starts with prefix, is longer than it and was
+// launched most, searching every provider whose entries are sorted by name.
+// NULL if there is none. Free with g_free().
+gchar* catalog_complete(Catalog *catalog, const gchar *prefix);
+
+// Remembers a command line typed and run in the launcher: adds it to the
+// command history and records the launch in the history's launch history.
+// A line new to the history only shows once the catalog is reloaded.
+void catalog_record_command(Catalog *catalog, const gchar *line);
+
+// Stops the workers and frees the catalog. Providers still loading finish in
+// the background and are discarded.
+void catalog_free(Catalog *catalog);
+
+#endif // CATALOG_H
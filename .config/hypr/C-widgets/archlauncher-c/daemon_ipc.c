@@ -0,0 +1,130 @@
+#define _GNU_SOURCE // accept4()
+#include "daemon_ipc.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// How long the daemon waits for a connected client to send its command
+#define RECEIVE_TIMEOUT_MS 100
+
+static gboolean socket_address(struct sockaddr_un *addr) {
+    gchar *path = g_build_filename(g_get_user_runtime_dir(), DAEMON_SOCKET_NAME, NULL);
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    gboolean fits = strlen(path) < sizeof(addr->sun_path);
+    if (fits) {
+        strcpy(addr->sun_path, path);
+    } else {
+        g_warning("Launcher socket path is too long: %s", path);
+    }
+    g_free(path);
+    return fits;
+}
+
+static gint connect_to_daemon(void) {
+    struct sockaddr_un addr;
+    if (!socket_address(&addr)) return -1;
+
+    gint fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+gint daemon_ipc_listen(void) {
+    struct sockaddr_un addr;
+    if (!socket_address(&addr)) return -1;
+
+    gint fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        g_warning("Failed to create launcher socket: %s", g_strerror(errno));
+        return -1;
+    }
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        if (errno != EADDRINUSE) {
+            g_warning("Failed to bind launcher socket: %s", g_strerror(errno));
+            close(fd);
+            return -1;
+        }
+        // Only take over the path if nobody answers on it.
+        gint other = connect_to_daemon();
+        if (other >= 0) {
+            close(other);
+            close(fd);
+            g_warning("Another launcher daemon is already running");
+            return -1;
+        }
+        unlink(addr.sun_path);
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            g_warning("Failed to bind launcher socket: %s", g_strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, 8) < 0) {
+        g_warning("Failed to listen on launcher socket: %s", g_strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+gchar* daemon_ipc_receive(gint listen_fd) {
+    gint fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    // A client that connects but never writes must not stall the UI.
+    struct timeval timeout = { 0, RECEIVE_TIMEOUT_MS * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    gchar buffer[DAEMON_MAX_COMMAND];
+    gsize length = 0;
+    while (length < sizeof(buffer) - 1) {
+        gssize n = read(fd, buffer + length, sizeof(buffer) - 1 - length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        length += n;
+        if (memchr(buffer, '\n', length)) break;
+    }
+    close(fd);
+
+    buffer[length] = '\0';
+    gchar *newline = strchr(buffer, '\n');
+    if (newline) *newline = '\0';
+    return length > 0 ? g_strdup(buffer) : NULL;
+}
+
+gboolean daemon_ipc_send(const gchar *command) {
+    gint fd = connect_to_daemon();
+    if (fd < 0) return FALSE;
+
+    gchar *line = g_strconcat(command, "\n", NULL);
+    gsize length = strlen(line);
+    gsize written = 0;
+    while (written < length) {
+        gssize n = write(fd, line + written, length - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    g_free(line);
+    close(fd);
+    return written == length;
+}
+
+void daemon_ipc_close(gint listen_fd) {
+    struct sockaddr_un addr;
+    if (listen_fd < 0) return;
+    close(listen_fd);
+    if (socket_address(&addr)) {
+        unlink(addr.sun_path);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef DAEMON_IPC_H
+#define DAEMON_IPC_H
+
+#include <glib.h>
+
+// Name of the launcher daemon's socket inside $XDG_RUNTIME_DIR
+#define DAEMON_SOCKET_NAME "cachy-launcher.sock"
+
+// Commands are a single line: a verb ("show", "hide", "toggle", "quit")
+// optionally followed by a mode ("drun", "run", "windows", "files", "emoji").
+#define DAEMON_MAX_COMMAND 256
+
+// Creates the daemon's listening socket, replacing a stale socket file left by
+// a daemon that died. Returns the non-blocking socket, or -1 if another daemon
+// is already listening or the socket could not be created.
+gint daemon_ipc_listen(void);
+
+// Accepts one pending client on listen_fd and returns the command it sent, or
+// NULL if there was none. Free the result with g_free().
+gchar* daemon_ipc_receive(gint listen_fd);
+
+// Sends command to the running daemon. Returns FALSE if no daemon is listening.
+// Needs no GTK, so thin clients can call it without gtk_init().
+gboolean daemon_ipc_send(const gchar *command);
+
+// Closes the listening socket and removes its file.
+void daemon_ipc_close(gint listen_fd);
+
+#endif // DAEMON_IPC_H
@@ -0,0 +1,477 @@
+#include "file_index.h"
+#include "app_info.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// On-disk Format
+// -----------------------------------------------------------------------------
+//
+// header | root | records
+//
+// root is the indexed directory ($HOME) and every record one path below it:
+//
+//   varint shared | varint suffix_len | suffix | type ('d' or 'f') [| varint mtime_sec | varint mtime_nsec]
+//
+// A record's path is the first `shared` bytes of the previous path followed by
+// suffix, the front coding locate uses. Records come depth-first with the
+// entries of each directory sorted by name, so a directory is followed by its
+// whole subtree and neighbouring paths share long prefixes. The first record
+// is the root itself, with an empty path. Directories carry the mtime they
+// were read at, which lets a refresh skip reading the unchanged ones.
+
+#define FILE_INDEX_MAGIC   0x58494643u // "CFIX"
+#define FILE_INDEX_VERSION 1
+
+#define INDEXER_MAX_THREADS 8
+#define INDEXER_BUFFER_SIZE (32 * 1024)
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 root_len;
+    guint32 n_entries;
+    guint64 data_size;
+} FileIndexHeader;
+
+struct _FileIndex {
+    GMappedFile *mapped;
+    const guint8 *data;
+    gsize data_size;
+    guint n_entries;
+};
+
+// Record layout returned by the getdents64 syscall
+struct linux_dirent64 {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// One directory as of its last read
+typedef struct {
+    gchar *path;         // Relative to the root, "" for the root itself
+    gint64 mtime_sec;
+    gint64 mtime_nsec;
+    GPtrArray *children; // Names sorted by name, each prefixed with its type ('d' or 'f')
+} DirRecord;
+
+// State shared by the indexer threads
+typedef struct {
+    const gchar *root;
+    dev_t root_dev;
+    GHashTable *previous; // Path -> DirRecord of the last index; only looked up while indexing
+    GThreadPool *pool;
+
+    GMutex lock;
+    GCond done;
+    guint n_pending;      // Directories queued or being indexed
+    GHashTable *records;  // Path -> DirRecord of this run
+    gint n_read;          // Directories that had to be read again
+} IndexBuild;
+
+// Writes the records of an index depth-first
+typedef struct {
+    GHashTable *records;
+    GByteArray *out;
+    GString *path;        // Path of the entry being written
+    GString *previous;    // Path of the entry written before it
+    guint n_entries;
+} IndexWriter;
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static gboolean read_varint(const guint8 **cursor, const guint8 *end, guint64 *value) {
+    guint64 result = 0;
+    for (guint shift = 0; shift < 64 && *cursor < end; shift += 7) {
+        guint8 byte = *(*cursor)++;
+        result |= (guint64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void write_varint(GByteArray *out, guint64 value) {
+    guint8 bytes[10];
+    guint n = 0;
+    do {
+        bytes[n] = value & 0x7f;
+        value >>= 7;
+        if (value) bytes[n] |= 0x80;
+        n++;
+    } while (value);
+    g_byte_array_append(out, bytes, n);
+}
+
+static DirRecord* dir_record_new(gchar *path) {
+    DirRecord *record = g_new0(DirRecord, 1);
+    record->path = path;
+    return record;
+}
+
+static void dir_record_free(gpointer data) {
+    DirRecord *record = data;
+    g_free(record->path);
+    if (record->children) g_ptr_array_unref(record->children);
+    g_free(record);
+}
+
+static gint compare_children(gconstpointer a, gconstpointer b) {
+    return strcmp(*(const gchar * const *)a + 1, *(const gchar * const *)b + 1);
+}
+
+static gchar* child_path(const gchar *dir, const gchar *name) {
+    return dir[0] != '\0' ? g_strconcat(dir, "/", name, NULL) : g_strdup(name);
+}
+
+// -----------------------------------------------------------------------------
+// Indexing
+// -----------------------------------------------------------------------------
+
+// Reads the entries of one directory with getdents64. Hidden entries are left
+// out, and symlinks are listed as files, never followed.
+static GPtrArray* read_children(const gchar *dir_path) {
+    GPtrArray *children = g_ptr_array_new_with_free_func(g_free);
+    int dir_fd = open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return children;
+
+    char *buffer = g_malloc(INDEXER_BUFFER_SIZE);
+    for (;;) {
+        long n_read = syscall(SYS_getdents64, dir_fd, buffer, INDEXER_BUFFER_SIZE);
+        if (n_read <= 0) break;
+
+        for (long offset = 0; offset < n_read; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)(buffer + offset);
+            offset += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            if (name[0] == '.') continue;
+
+            gboolean is_dir = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat st;
+                is_dir = fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+            }
+            g_ptr_array_add(children, g_strconcat(is_dir ? "d" : "f", name, NULL));
+        }
+    }
+    g_free(buffer);
+    close(dir_fd);
+
+    g_ptr_array_sort(children, compare_children);
+    return children;
+}
+
+static void queue_dir(IndexBuild *build, gchar *path) {
+    g_mutex_lock(&build->lock);
+    build->n_pending++;
+    g_mutex_unlock(&build->lock);
+    g_thread_pool_push(build->pool, path, NULL);
+}
+
+// Indexes one directory and queues its subdirectories, so the pool works
+// through the tree breadth-first with every thread busy.
+static void index_dir_worker(gpointer data, gpointer user_data) {
+    IndexBuild *build = user_data;
+    DirRecord *record = dir_record_new(data);
+
+    gchar *full_path = record->path[0] != '\0' ? g_build_filename(build->root, record->path, NULL)
+                                               : g_strdup(build->root);
+    struct stat st;
+    // Other filesystems mounted below the root (network shares, removable
+    // drives) are listed but not descended into, like find -xdev.
+    // Symlinks are never followed, except for the root itself.
+    gint status = record->path[0] != '\0' ? lstat(full_path, &st) : stat(full_path, &st);
+    if (status == 0 && S_ISDIR(st.st_mode) && st.st_dev == build->root_dev) {
+        record->mtime_sec = st.st_mtim.tv_sec;
+        record->mtime_nsec = st.st_mtim.tv_nsec;
+
+        DirRecord *previous = g_hash_table_lookup(build->previous, record->path);
+        if (previous && previous->children && previous->mtime_sec == record->mtime_sec &&
+            previous->mtime_nsec == record->mtime_nsec) {
+            // Nothing was added, removed or renamed in it; only its
+            // subdirectories can have changed. Every directory is indexed
+            // exactly once, so no other thread touches this record.
+            record->children = previous->children;
+            previous->children = NULL;
+        } else {
+            record->children = read_children(full_path);
+            g_atomic_int_inc(&build->n_read);
+        }
+
+        for (guint i = 0; i < record->children->len; i++) {
+            const gchar *child = g_ptr_array_index(record->children, i);
+            if (child[0] == 'd') {
+                queue_dir(build, child_path(record->path, child + 1));
+            }
+        }
+    }
+    if (!record->children) {
+        record->children = g_ptr_array_new_with_free_func(g_free);
+    }
+    g_free(full_path);
+
+    g_mutex_lock(&build->lock);
+    g_hash_table_insert(build->records, record->path, record);
+    if (--build->n_pending == 0) {
+        g_cond_signal(&build->done);
+    }
+    g_mutex_unlock(&build->lock);
+}
+
+// Rebuilds the directory records of an existing index, for reuse.
+static void read_previous(FileIndex *index, GHashTable *records) {
+    FileIndexIter iter;
+    file_index_iter_init(index, &iter);
+    while (file_index_iter_next(&iter)) {
+        if (iter.length > 0) {
+            // Depth-first order: the parent's record always exists by now.
+            const gchar *slash = strrchr(iter.path, '/');
+            gchar *parent_path = slash ? g_strndup(iter.path, slash - iter.path) : g_strdup("");
+            DirRecord *parent = g_hash_table_lookup(records, parent_path);
+            if (parent) {
+                g_ptr_array_add(parent->children,
+                                g_strconcat(iter.is_dir ? "d" : "f", slash ? slash + 1 : iter.path, NULL));
+            }
+            g_free(parent_path);
+        }
+        if (iter.is_dir) {
+            DirRecord *record = dir_record_new(g_strdup(iter.path));
+            record->mtime_sec = iter.mtime_sec;
+            record->mtime_nsec = iter.mtime_nsec;
+            record->children = g_ptr_array_new_with_free_func(g_free);
+            g_hash_table_replace(records, record->path, record);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Writing the Index
+// -----------------------------------------------------------------------------
+
+static void write_entry(IndexWriter *writer, const DirRecord *dir) {
+    const gchar *path = writer->path->str;
+    gsize shared = 0;
+    while (shared < writer->path->len && shared < writer->previous->len &&
+           path[shared] == writer->previous->str[shared]) {
+        shared++;
+    }
+
+    write_varint(writer->out, shared);
+    write_varint(writer->out, writer->path->len - shared);
+    g_byte_array_append(writer->out, (const guint8 *)path + shared, writer->path->len - shared);
+    guint8 type = dir ? 'd' : 'f';
+    g_byte_array_append(writer->out, &type, 1);
+    if (dir) {
+        write_varint(writer->out, dir->mtime_sec);
+        write_varint(writer->out, dir->mtime_nsec);
+    }
+
+    g_string_truncate(writer->previous, shared);
+    g_string_append(writer->previous, path + shared);
+    writer->n_entries++;
+}
+
+// Writes dir (whose path is writer->path) and its subtree.
+static void write_dir(IndexWriter *writer, const DirRecord *dir) {
+    write_entry(writer, dir);
+    gsize length = writer->path->len;
+    for (guint i = 0; i < dir->children->len; i++) {
+        const gchar *child = g_ptr_array_index(dir->children, i);
+        if (length > 0) g_string_append_c(writer->path, '/');
+        g_string_append(writer->path, child + 1);
+
+        if (writer->path->len < FILE_INDEX_MAX_PATH) {
+            if (child[0] == 'f') {
+                write_entry(writer, NULL);
+            } else {
+                DirRecord *subdir = g_hash_table_lookup(writer->records, writer->path->str);
+                if (subdir) write_dir(writer, subdir);
+            }
+        }
+        g_string_truncate(writer->path, length);
+    }
+}
+
+static gboolean write_index(const gchar *root, GHashTable *records, guint *n_entries) {
+    DirRecord *root_record = g_hash_table_lookup(records, "");
+    if (!root_record) return FALSE;
+
+    IndexWriter writer = { records, g_byte_array_new(), g_string_new(NULL), g_string_new(NULL), 0 };
+    write_dir(&writer, root_record);
+
+    FileIndexHeader header = { FILE_INDEX_MAGIC, FILE_INDEX_VERSION, strlen(root), writer.n_entries,
+                               writer.out->len };
+    GByteArray *buffer = g_byte_array_sized_new(sizeof(header) + header.root_len + writer.out->len);
+    g_byte_array_append(buffer, (const guint8 *)&header, sizeof(header));
+    g_byte_array_append(buffer, (const guint8 *)root, header.root_len);
+    g_byte_array_append(buffer, writer.out->data, writer.out->len);
+
+    // Written to a temporary file and renamed into place, so a running
+    // launcher keeps its mapping of the old index intact.
+    gchar *path = launcher_cache_path(FILE_INDEX_FILE);
+    GError *error = NULL;
+    gboolean ok = g_file_set_contents(path, (const gchar *)buffer->data, buffer->len, &error);
+    if (!ok) {
+        g_warning("Failed to write file index: %s", error->message);
+        g_error_free(error);
+    }
+    *n_entries = writer.n_entries;
+
+    g_free(path);
+    g_byte_array_unref(buffer);
+    g_string_free(writer.previous, TRUE);
+    g_string_free(writer.path, TRUE);
+    g_byte_array_unref(writer.out);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+gboolean file_index_needs_update(void) {
+    gchar *path = launcher_cache_path(FILE_INDEX_FILE);
+    GStatBuf st;
+    gboolean stale = g_stat(path, &st) != 0 || time(NULL) - st.st_mtime > FILE_INDEX_MAX_AGE;
+    g_free(path);
+    return stale;
+}
+
+gboolean file_index_update(gboolean force_rebuild) {
+    gint64 start = g_get_monotonic_time();
+    IndexBuild build = { 0 };
+    build.root = g_get_home_dir();
+    struct stat st;
+    if (stat(build.root, &st) != 0) {
+        g_warning("Cannot index %s: %s", build.root, g_strerror(errno));
+        return FALSE;
+    }
+    build.root_dev = st.st_dev;
+
+    build.previous = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, dir_record_free);
+    build.records = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, dir_record_free);
+    FileIndex *old = force_rebuild ? NULL : file_index_open();
+    if (old) {
+        read_previous(old, build.previous);
+        file_index_free(old);
+    }
+
+    g_mutex_init(&build.lock);
+    g_cond_init(&build.done);
+    gint n_threads = MIN(g_get_num_processors(), INDEXER_MAX_THREADS);
+    build.pool = g_thread_pool_new(index_dir_worker, &build, n_threads, FALSE, NULL);
+    queue_dir(&build, g_strdup(""));
+
+    g_mutex_lock(&build.lock);
+    while (build.n_pending > 0) {
+        g_cond_wait(&build.done, &build.lock);
+    }
+    g_mutex_unlock(&build.lock);
+    // Waits for the thread that finished the last directory to return.
+    g_thread_pool_free(build.pool, FALSE, TRUE);
+
+    guint n_entries = 0;
+    gboolean ok = write_index(build.root, build.records, &n_entries);
+    g_debug("File index: %u entries, %d of %u directories read, written after %.2f ms", n_entries,
+            build.n_read, g_hash_table_size(build.records), (g_get_monotonic_time() - start) / 1000.0);
+
+    g_cond_clear(&build.done);
+    g_mutex_clear(&build.lock);
+    g_hash_table_destroy(build.records);
+    g_hash_table_destroy(build.previous);
+    return ok;
+}
+
+FileIndex* file_index_open(void) {
+    gchar *path = launcher_cache_path(FILE_INDEX_FILE);
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    g_free(path);
+    if (!mapped) return NULL;
+
+    const gchar *contents = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    const FileIndexHeader *header = (const FileIndexHeader *)contents;
+    const gchar *root = g_get_home_dir();
+    if (length < sizeof(FileIndexHeader) || header->magic != FILE_INDEX_MAGIC ||
+        header->version != FILE_INDEX_VERSION ||
+        sizeof(FileIndexHeader) + (guint64)header->root_len + header->data_size != length ||
+        header->root_len != strlen(root) || memcmp(contents + sizeof(FileIndexHeader), root, header->root_len) != 0) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    FileIndex *index = g_new(FileIndex, 1);
+    index->mapped = mapped;
+    index->data = (const guint8 *)contents + sizeof(FileIndexHeader) + header->root_len;
+    index->data_size = header->data_size;
+    index->n_entries = header->n_entries;
+    return index;
+}
+
+guint file_index_get_n_entries(FileIndex *index) {
+    return index->n_entries;
+}
+
+void file_index_iter_init(FileIndex *index, FileIndexIter *iter) {
+    iter->cursor = index->data;
+    iter->end = index->data + index->data_size;
+    iter->path[0] = '\0';
+    iter->length = 0;
+    iter->is_dir = FALSE;
+    iter->mtime_sec = 0;
+    iter->mtime_nsec = 0;
+}
+
+gboolean file_index_iter_next(FileIndexIter *iter) {
+    guint64 shared, suffix_len;
+    if (iter->cursor >= iter->end) return FALSE;
+    if (!read_varint(&iter->cursor, iter->end, &shared) || !read_varint(&iter->cursor, iter->end, &suffix_len) ||
+        shared > iter->length || suffix_len >= FILE_INDEX_MAX_PATH - shared ||
+        suffix_len >= (guint64)(iter->end - iter->cursor)) {
+        iter->cursor = iter->end;
+        return FALSE;
+    }
+    memcpy(iter->path + shared, iter->cursor, suffix_len);
+    iter->cursor += suffix_len;
+    iter->length = shared + suffix_len;
+    iter->path[iter->length] = '\0';
+
+    guint8 type = *iter->cursor++;
+    iter->is_dir = type == 'd';
+    iter->mtime_sec = 0;
+    iter->mtime_nsec = 0;
+    if (iter->is_dir) {
+        guint64 sec, nsec;
+        if (!read_varint(&iter->cursor, iter->end, &sec) || !read_varint(&iter->cursor, iter->end, &nsec)) {
+            iter->cursor = iter->end;
+            return FALSE;
+        }
+        iter->mtime_sec = sec;
+        iter->mtime_nsec = nsec;
+    } else if (type != 'f') {
+        iter->cursor = iter->end;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void file_index_free(FileIndex *index) {
+    if (!index) return;
+    g_mapped_file_unref(index->mapped);
+    g_free(index);
+}
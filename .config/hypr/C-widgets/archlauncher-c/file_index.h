@@ -0,0 +1,54 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <glib.h>
+
+// Name of the file search database inside ~/.cache/cachy/
+#define FILE_INDEX_FILE "file_index.bin"
+
+// Age in seconds after which the index is refreshed before use
+#define FILE_INDEX_MAX_AGE (10 * 60)
+
+// Longest path (relative to the home directory, in bytes) the index keeps
+#define FILE_INDEX_MAX_PATH 4096
+
+// A locate-style database of every file and directory below $HOME, sorted and
+// prefix-compressed, read straight from a memory mapping.
+typedef struct _FileIndex FileIndex;
+
+// Walks the entries of a FileIndex in order. Directories come before their
+// contents and the entries of each directory are sorted by name.
+typedef struct {
+    const guint8 *cursor;
+    const guint8 *end;
+    gchar path[FILE_INDEX_MAX_PATH]; // Relative to the home directory, "" for the home directory itself
+    gsize length;
+    gboolean is_dir;
+    gint64 mtime_sec;                // Of a directory when it was last read
+    gint64 mtime_nsec;
+} FileIndexIter;
+
+// TRUE if the index is missing or older than FILE_INDEX_MAX_AGE.
+gboolean file_index_needs_update(void);
+
+// Brings the index up to date, reading the directories on a small worker
+// pool. Only directories whose mtime changed since the last run are read
+// again; the others are just stat'ed. force_rebuild reads all of them.
+// Returns FALSE if the index could not be written.
+gboolean file_index_update(gboolean force_rebuild);
+
+// Maps the index. Returns NULL if there is none, it is unreadable or it was
+// built for another home directory.
+FileIndex* file_index_open(void);
+
+guint file_index_get_n_entries(FileIndex *index);
+
+void file_index_iter_init(FileIndex *index, FileIndexIter *iter);
+
+// Advances to the next entry. Returns FALSE at the end, or if the rest of the
+// index is corrupt.
+gboolean file_index_iter_next(FileIndexIter *iter);
+
+void file_index_free(FileIndex *index);
+
+#endif // FILE_INDEX_H
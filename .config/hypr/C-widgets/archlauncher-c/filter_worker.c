@@ -0,0 +1,228 @@
+#include "filter_worker.h"
+#include "app_info.h"
+
+// How many candidates are scored between checks for a newer query
+#define CANCEL_CHECK_INTERVAL 256
+
+// A query waiting for the worker thread. text == NULL asks the thread to exit.
+typedef struct {
+    guint generation;
+    gchar *text;
+} FilterJob;
+
+struct _FilterWorker {
+    gint ref_count;
+    GPtrArray *apps;
+    SearchIndex *index;
+    const gdouble *frecency;
+    FilterResultCallback callback;
+    gpointer user_data;
+
+    GThread *thread;
+    GAsyncQueue *jobs;
+    gint latest_generation; // Accessed atomically from both threads
+    gint closed;            // Set once filter_worker_free() ran
+
+    // Worker-thread-only: the last query that ran to completion and the ids it
+    // matched, in ascending order, for narrowing the next query.
+    gchar *last_key;
+    GArray *last_ids;
+};
+
+// A finished result on its way to the main loop
+typedef struct {
+    FilterWorker *worker;
+    FilterResult *result;
+} FilterDelivery;
+
+static FilterWorker* filter_worker_ref(FilterWorker *worker) {
+    g_atomic_int_inc(&worker->ref_count);
+    return worker;
+}
+
+static void filter_worker_unref(FilterWorker *worker) {
+    if (!g_atomic_int_dec_and_test(&worker->ref_count)) return;
+    g_async_queue_unref(worker->jobs);
+    g_free(worker->last_key);
+    if (worker->last_ids) g_array_unref(worker->last_ids);
+    g_free(worker);
+}
+
+static void filter_job_free(gpointer data) {
+    FilterJob *job = data;
+    g_free(job->text);
+    g_free(job);
+}
+
+void filter_result_free(FilterResult *result) {
+    if (!result) return;
+    g_array_unref(result->matches);
+    g_free(result);
+}
+
+static gboolean is_stale(FilterWorker *worker, guint generation) {
+    return (guint)g_atomic_int_get(&worker->latest_generation) != generation;
+}
+
+// Best score first; among equal scores the more frecent app, then list
+// (alphabetical) order.
+static gint compare_matches(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const FilterMatch *match_a = a;
+    const FilterMatch *match_b = b;
+    const gdouble *frecency = user_data;
+    if (match_a->score != match_b->score) {
+        return match_a->score > match_b->score ? -1 : 1;
+    }
+    if (frecency && frecency[match_a->id] != frecency[match_b->id]) {
+        return frecency[match_a->id] > frecency[match_b->id] ? -1 : 1;
+    }
+    return match_a->id < match_b->id ? -1 : (match_a->id > match_b->id);
+}
+
+// -----------------------------------------------------------------------------
+// Worker Thread
+// -----------------------------------------------------------------------------
+
+static gboolean deliver_result(gpointer user_data) {
+    FilterDelivery *delivery = user_data;
+    FilterWorker *worker = delivery->worker;
+
+    // A newer keystroke may have arrived while this result was queued.
+    if (!g_atomic_int_get(&worker->closed) && !is_stale(worker, delivery->result->generation)) {
+        worker->callback(delivery->result, worker->user_data);
+    } else {
+        filter_result_free(delivery->result);
+    }
+    filter_worker_unref(worker);
+    g_free(delivery);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs one query. Returns NULL if it was cancelled by a newer one.
+static FilterResult* run_filter(FilterWorker *worker, FilterJob *job) {
+    FilterResult *result = g_new(FilterResult, 1);
+    result->generation = job->generation;
+    gchar *key = search_key_new(job->text);
+    fuzzy_query_init(&result->query, key);
+    g_free(key);
+    const FuzzyQuery *query = &result->query;
+
+    // Every match of a query is also a match of any prefix of it, so when the
+    // user keeps typing only the previous matches need to be rescored...
+    guint n_candidates;
+    const guint32 *candidates = NULL;
+    gboolean narrowed = FALSE;
+    if (worker->last_key && g_str_has_prefix(query->text, worker->last_key)) {
+        candidates = (const guint32 *)worker->last_ids->data;
+        n_candidates = worker->last_ids->len;
+        narrowed = TRUE;
+    }
+    // ...unless the index has an even smaller candidate set.
+    guint n_indexed;
+    const guint32 *indexed = search_index_candidates(worker->index, query->text, &n_indexed);
+    if (!narrowed || (indexed && n_indexed < n_candidates)) {
+        candidates = indexed;
+        n_candidates = n_indexed;
+    }
+
+    result->matches = g_array_new(FALSE, FALSE, sizeof(FilterMatch));
+    for (guint i = 0; i < n_candidates; i++) {
+        if (i % CANCEL_CHECK_INTERVAL == 0 && is_stale(worker, job->generation)) {
+            filter_result_free(result);
+            return NULL;
+        }
+        FilterMatch match;
+        match.id = candidates ? candidates[i] : i;
+        AppInfo *app = g_ptr_array_index(worker->apps, match.id);
+        if (fuzzy_match(query, app->key, app->key_aligned ? app->name : NULL, app->char_mask,
+                        &match.score, NULL)) {
+            g_array_append_val(result->matches, match);
+        }
+    }
+
+    // Candidates come in ascending id order, so the matches do too; remember
+    // them for narrowing before they get sorted by score.
+    GArray *ids = g_array_sized_new(FALSE, FALSE, sizeof(guint32), result->matches->len);
+    for (guint i = 0; i < result->matches->len; i++) {
+        g_array_append_val(ids, g_array_index(result->matches, FilterMatch, i).id);
+    }
+    g_free(worker->last_key);
+    if (worker->last_ids) g_array_unref(worker->last_ids);
+    worker->last_key = g_strdup(query->text);
+    worker->last_ids = ids;
+
+    g_array_sort_with_data(result->matches, compare_matches, (gpointer)worker->frecency);
+    return result;
+}
+
+static gpointer filter_thread_func(gpointer user_data) {
+    FilterWorker *worker = user_data;
+
+    for (;;) {
+        FilterJob *job = g_async_queue_pop(worker->jobs);
+        // Skip straight to the newest query if several piled up.
+        FilterJob *newer;
+        while (job->text && (newer = g_async_queue_try_pop(worker->jobs))) {
+            filter_job_free(job);
+            job = newer;
+        }
+        if (!job->text) {
+            filter_job_free(job);
+            break;
+        }
+
+        FilterResult *result = is_stale(worker, job->generation) ? NULL : run_filter(worker, job);
+        filter_job_free(job);
+        if (result) {
+            FilterDelivery *delivery = g_new(FilterDelivery, 1);
+            delivery->worker = filter_worker_ref(worker);
+            delivery->result = result;
+            g_idle_add_full(G_PRIORITY_HIGH_IDLE, deliver_result, delivery, NULL);
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FilterWorker* filter_worker_new(GPtrArray *apps, SearchIndex *index, const gdouble *frecency,
+                                FilterResultCallback callback, gpointer user_data) {
+    FilterWorker *worker = g_new0(FilterWorker, 1);
+    worker->ref_count = 1;
+    worker->apps = apps;
+    worker->index = index;
+    worker->frecency = frecency;
+    worker->callback = callback;
+    worker->user_data = user_data;
+    worker->jobs = g_async_queue_new();
+    worker->thread = g_thread_new("launcher-filter", filter_thread_func, worker);
+    return worker;
+}
+
+guint filter_worker_submit(FilterWorker *worker, const gchar *text) {
+    FilterJob *job = g_new(FilterJob, 1);
+    // Bumping the generation first makes a running query notice it is stale.
+    job->generation = g_atomic_int_add(&worker->latest_generation, 1) + 1;
+    job->text = g_strdup(text);
+    g_async_queue_push(worker->jobs, job);
+    return job->generation;
+}
+
+void filter_worker_free(FilterWorker *worker) {
+    if (!worker) return;
+    g_atomic_int_set(&worker->closed, TRUE);
+    g_atomic_int_inc(&worker->latest_generation);
+
+    FilterJob *quit = g_new0(FilterJob, 1);
+    g_async_queue_push(worker->jobs, quit);
+    g_thread_join(worker->thread);
+
+    // Drop anything queued behind the quit job.
+    FilterJob *job;
+    while ((job = g_async_queue_try_pop(worker->jobs))) {
+        filter_job_free(job);
+    }
+    filter_worker_unref(worker);
+}
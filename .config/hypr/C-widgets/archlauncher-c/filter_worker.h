@@ -0,0 +1,43 @@
+#ifndef FILTER_WORKER_H
+#define FILTER_WORKER_H
+
+#include <glib.h>
+#include "fuzzy.h"
+#include "search_index.h"
+
+// One entry that matched a query
+typedef struct {
+    guint32 id;    // Position of the AppInfo in the worker's apps array
+    gint score;
+} FilterMatch;
+
+// The complete outcome of one query, delivered to the main loop in one piece
+typedef struct {
+    guint generation;
+    FuzzyQuery query;  // The folded query, for computing highlight positions
+    GArray *matches;   // FilterMatch, best score first, ties by frecency, then list order
+} FilterResult;
+
+// Called on the main loop with the result of the newest query. The callback
+// takes ownership of the result and frees it with filter_result_free().
+typedef void (*FilterResultCallback)(FilterResult *result, gpointer user_data);
+
+typedef struct _FilterWorker FilterWorker;
+
+// Starts a worker thread that filters apps (an array of AppInfo that must stay
+// alive and unchanged until the worker is freed) with the help of index.
+// frecency, if not NULL, holds one launch history score per app and orders
+// matches with equal scores; it must stay alive as long as apps.
+FilterWorker* filter_worker_new(GPtrArray *apps, SearchIndex *index, const gdouble *frecency,
+                                FilterResultCallback callback, gpointer user_data);
+
+// Queues a query and returns its generation number. Any query still pending or
+// running is cancelled; only the newest generation is ever delivered.
+guint filter_worker_submit(FilterWorker *worker, const gchar *text);
+
+// Cancels outstanding work, joins the thread and frees the worker.
+void filter_worker_free(FilterWorker *worker);
+
+void filter_result_free(FilterResult *result);
+
+#endif // FILTER_WORKER_H
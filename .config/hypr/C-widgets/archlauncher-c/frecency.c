@@ -0,0 +1,226 @@
+#include "frecency.h"
+#include "app_info.h"
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// On-disk Format
+// -----------------------------------------------------------------------------
+//
+// header | record | record | ...
+//
+// Each record is a FrecencyRecord followed by key_len bytes of key, padded to
+// a multiple of 8. A record says "key had this weight at this time"; the score
+// of a key is the sum of its records' weights, each decayed from its own time.
+// A launch appends a record of weight 1, and compacting rewrites the file with
+// one record per key holding its current score.
+
+#define FRECENCY_MAGIC   0x43524643u // "CFRC"
+#define FRECENCY_VERSION 1
+// Records allowed beyond one per key before the next launch compacts the file
+#define COMPACT_SLACK    32
+// Scores below this are dropped when compacting
+#define MIN_SCORE        0.01
+#define MAX_KEY_LEN      4096
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+} FrecencyHeader;
+
+typedef struct {
+    gint64 time;      // Unix time in seconds the weight applies to
+    gfloat weight;
+    guint32 key_len;
+} FrecencyRecord;
+
+struct _FrecencyStore {
+    gchar *path;
+    gint64 now;         // When the store was loaded; all scores are as of then
+    GHashTable *scores; // key -> gdouble*, decayed to now
+    guint n_records;    // Records in the file, for deciding when to compact
+};
+
+#define RECORD_PADDING(len) ((8 - (len) % 8) % 8)
+
+static gdouble decay(gdouble weight, gint64 from, gint64 to) {
+    if (to <= from) return weight;
+    return weight * exp2(-(gdouble)(to - from) / (FRECENCY_HALF_LIFE_DAYS * 86400.0));
+}
+
+static void add_score(FrecencyStore *store, const gchar *key, gdouble score) {
+    gdouble *value = g_hash_table_lookup(store->scores, key);
+    if (!value) {
+        value = g_new0(gdouble, 1);
+        g_hash_table_insert(store->scores, g_strdup(key), value);
+    }
+    *value += score;
+}
+
+static void append_record(GString *out, gint64 time, gdouble weight, const gchar *key) {
+    static const gchar zeros[8] = { 0 };
+    FrecencyRecord record;
+    record.time = time;
+    record.weight = weight;
+    record.key_len = strlen(key);
+    g_string_append_len(out, (const gchar *)&record, sizeof(record));
+    g_string_append_len(out, key, record.key_len);
+    g_string_append_len(out, zeros, RECORD_PADDING(record.key_len));
+}
+
+// Maps the file and folds its records into store->scores. A record cut short by
+// an interrupted append (or garbage) ends the read; everything before it still
+// counts. Returns FALSE if the read stopped short of the end of the file.
+static gboolean read_records(FrecencyStore *store) {
+    GMappedFile *mapped = g_mapped_file_new(store->path, FALSE, NULL);
+    if (!mapped) return TRUE;
+
+    const gchar *contents = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    const FrecencyHeader *header = (const FrecencyHeader *)contents;
+    if (length < sizeof(FrecencyHeader) || header->magic != FRECENCY_MAGIC ||
+        header->version != FRECENCY_VERSION) {
+        g_mapped_file_unref(mapped);
+        return FALSE;
+    }
+
+    gsize pos = sizeof(FrecencyHeader);
+    while (pos + sizeof(FrecencyRecord) <= length) {
+        FrecencyRecord record;
+        memcpy(&record, contents + pos, sizeof(record));
+        gsize size = sizeof(record) + record.key_len + RECORD_PADDING(record.key_len);
+        if (record.key_len == 0 || record.key_len > MAX_KEY_LEN || size > length - pos) break;
+
+        // Keys are not NUL-terminated when their length is a multiple of 8.
+        gchar *key = g_strndup(contents + pos + sizeof(record), record.key_len);
+        add_score(store, key, decay(record.weight, record.time, store->now));
+        g_free(key);
+        store->n_records++;
+        pos += size;
+    }
+    g_mapped_file_unref(mapped);
+    return pos == length;
+}
+
+// Takes the lock that serializes writers of the file across processes. It
+// lives in a file of its own, as compacting replaces the history file.
+// Returns the descriptor to close for unlocking, or -1 if locking failed.
+static int lock_history(FrecencyStore *store) {
+    gchar *lock_path = g_strconcat(store->path, ".lock", NULL);
+    int fd = g_open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    g_free(lock_path);
+    if (fd < 0) return -1;
+    while (flock(fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// Rewrites the file with one record per key, dropping keys that decayed away.
+static void compact(FrecencyStore *store) {
+    GString *out = g_string_new(NULL);
+    FrecencyHeader header = { FRECENCY_MAGIC, FRECENCY_VERSION };
+    g_string_append_len(out, (const gchar *)&header, sizeof(header));
+
+    guint n_records = 0;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, store->scores);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gdouble score = *(gdouble *)value;
+        if (score < MIN_SCORE) continue;
+        append_record(out, store->now, score, key);
+        n_records++;
+    }
+
+    GError *error = NULL;
+    if (g_file_set_contents(store->path, out->str, out->len, &error)) {
+        store->n_records = n_records;
+    } else {
+        g_warning("Failed to compact launch history: %s", error->message);
+        g_error_free(error);
+    }
+    g_string_free(out, TRUE);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+FrecencyStore* frecency_store_load(const gchar *file_name) {
+    FrecencyStore *store = g_new0(FrecencyStore, 1);
+    store->path = launcher_cache_path(file_name);
+    store->now = g_get_real_time() / G_USEC_PER_SEC;
+    store->scores = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    read_records(store);
+    return store;
+}
+
+gdouble frecency_store_score(FrecencyStore *store, const gchar *key) {
+    gdouble *value = g_hash_table_lookup(store->scores, key);
+    return value ? *value : 0.0;
+}
+
+void frecency_store_add(FrecencyStore *store, const gchar *key) {
+    gsize key_len = strlen(key);
+    if (key_len == 0 || key_len > MAX_KEY_LEN) return;
+
+    int lock_fd = lock_history(store);
+    if (lock_fd < 0) {
+        g_warning("Failed to lock launch history: %s", g_strerror(errno));
+    }
+
+    // Other launcher processes (the daemon, one-shot runs) may have appended
+    // or compacted since this store was loaded, so start again from the file
+    // as it is now, with the scores brought up to the launch time. A
+    // compaction then writes everyone's launches, not just this process's.
+    gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    g_hash_table_remove_all(store->scores);
+    store->n_records = 0;
+    store->now = now;
+    gboolean intact = read_records(store);
+    add_score(store, key, 1.0);
+
+    // A new (or unreadable) file gets written from scratch, and so does one
+    // that has piled up too many records. So does a file with a torn or
+    // garbage record: anything appended after it would never be read back.
+    if (!intact || store->n_records == 0 ||
+        store->n_records + 1 > g_hash_table_size(store->scores) + COMPACT_SLACK) {
+        compact(store);
+        if (lock_fd >= 0) close(lock_fd);
+        return;
+    }
+
+    int fd = g_open(store->path, O_WRONLY | O_APPEND | O_CLOEXEC, 0);
+    if (fd < 0) {
+        g_warning("Failed to open launch history: %s", g_strerror(errno));
+        if (lock_fd >= 0) close(lock_fd);
+        return;
+    }
+
+    GString *out = g_string_new(NULL);
+    append_record(out, now, 1.0, key);
+    if (write(fd, out->str, out->len) != (gssize)out->len) {
+        g_warning("Failed to append to launch history: %s", g_strerror(errno));
+    } else {
+        store->n_records++;
+    }
+    close(fd);
+    if (lock_fd >= 0) close(lock_fd);
+    g_string_free(out, TRUE);
+}
+
+void frecency_store_free(FrecencyStore *store) {
+    if (!store) return;
+    g_hash_table_destroy(store->scores);
+    g_free(store->path);
+    g_free(store);
+}
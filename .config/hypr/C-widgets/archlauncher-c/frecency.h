@@ -0,0 +1,35 @@
+#ifndef FRECENCY_H
+#define FRECENCY_H
+
+#include <glib.h>
+
+// Names of the launch history files inside ~/.cache/cachy/, one per provider
+// that keeps one
+#define FRECENCY_DRUN_FILE "frecency_drun.bin"
+#define FRECENCY_RUN_FILE "frecency_run.bin"
+#define FRECENCY_HISTORY_FILE "frecency_history.bin" // Command lines, keyed by the line
+#define FRECENCY_FILES_FILE "frecency_files.bin"
+#define FRECENCY_EMOJI_FILE "frecency_emoji.bin"
+
+// Launch counts with exponential time decay: every launch adds 1 to an entry's
+// score and scores halve every FRECENCY_HALF_LIFE_DAYS.
+#define FRECENCY_HALF_LIFE_DAYS 7
+
+typedef struct _FrecencyStore FrecencyStore;
+
+// Reads the launch history from the cache directory. Never returns NULL; a
+// missing or unreadable file just gives an empty store.
+FrecencyStore* frecency_store_load(const gchar *file_name);
+
+// The decayed score of key as of loading, 0 for keys never launched.
+gdouble frecency_store_score(FrecencyStore *store, const gchar *key);
+
+// Records a launch of key. Usually appends one small record to the file; once
+// enough records piled up the file is compacted to one record per key instead.
+// Both happen under a lock, after rereading the file, so launches recorded by
+// other launcher processes since this store was loaded are kept.
+void frecency_store_add(FrecencyStore *store, const gchar *key);
+
+void frecency_store_free(FrecencyStore *store);
+
+#endif // FRECENCY_H
@@ -0,0 +1,131 @@
+#include "fuzzy.h"
+#include <string.h>
+
+// Scoring constants, modelled on fzf's
+#define SCORE_MATCH                 16
+#define SCORE_GAP_START             -3
+#define SCORE_GAP_EXTENSION         -1
+#define BONUS_BOUNDARY              (SCORE_MATCH / 2)
+#define BONUS_CAMEL                 (BONUS_BOUNDARY - 1)
+#define BONUS_CONSECUTIVE           (-(SCORE_GAP_START + SCORE_GAP_EXTENSION))
+#define BONUS_FIRST_CHAR_MULTIPLIER 2
+
+typedef enum {
+    CHAR_NONWORD,
+    CHAR_LOWER,
+    CHAR_UPPER,
+    CHAR_DIGIT
+} CharClass;
+
+static CharClass char_class(guchar c) {
+    if (c >= 'a' && c <= 'z') return CHAR_LOWER;
+    if (c >= 'A' && c <= 'Z') return CHAR_UPPER;
+    if (c >= '0' && c <= '9') return CHAR_DIGIT;
+    // Bytes of multi-byte UTF-8 characters count as letters.
+    if (c >= 0x80) return CHAR_LOWER;
+    return CHAR_NONWORD;
+}
+
+static gint char_bonus(CharClass prev, CharClass cur) {
+    if (cur == CHAR_NONWORD) return 0;
+    if (prev == CHAR_NONWORD) return BONUS_BOUNDARY;
+    if (prev == CHAR_LOWER && cur == CHAR_UPPER) return BONUS_CAMEL;
+    if (prev != CHAR_DIGIT && cur == CHAR_DIGIT) return BONUS_CAMEL;
+    return 0;
+}
+
+static inline guint mask_bit(guchar c) {
+    c = g_ascii_tolower(c);
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= '0' && c <= '9') return 26 + (c - '0');
+    return 36 + (c % 28);
+}
+
+guint64 fuzzy_char_mask(const gchar *str) {
+    guint64 mask = 0;
+    for (const guchar *p = (const guchar *)str; *p; p++) {
+        mask |= G_GUINT64_CONSTANT(1) << mask_bit(*p);
+    }
+    return mask;
+}
+
+void fuzzy_query_init(FuzzyQuery *query, const gchar *text) {
+    gsize len = strlen(text);
+    if (len > FUZZY_MAX_QUERY) {
+        len = FUZZY_MAX_QUERY;
+        // Don't cut a UTF-8 character in half.
+        while (len > 0 && ((guchar)text[len] & 0xC0) == 0x80) len--;
+    }
+    for (gsize i = 0; i < len; i++) {
+        query->text[i] = g_ascii_tolower(text[i]);
+    }
+    query->text[len] = '\0';
+    query->len = len;
+    query->mask = fuzzy_char_mask(query->text);
+}
+
+gboolean fuzzy_match(const FuzzyQuery *query, const gchar *candidate, const gchar *cased,
+                     guint64 candidate_mask, gint *score, guint *positions) {
+    const gchar *q = query->text;
+    gsize q_len = query->len;
+
+    *score = 0;
+    if (q_len == 0) return TRUE;
+    if ((query->mask & ~candidate_mask) != 0) return FALSE;
+
+    // 1. Forward pass: find where the earliest complete match ends.
+    gsize q_index = 0;
+    gsize end = 0;
+    for (gsize i = 0; candidate[i]; i++) {
+        if (g_ascii_tolower(candidate[i]) == q[q_index] && ++q_index == q_len) {
+            end = i + 1;
+            break;
+        }
+    }
+    if (q_index < q_len) return FALSE;
+
+    // 2. Backward pass: from that end, find the latest start, i.e. the tightest window.
+    gsize start = 0;
+    for (gsize i = end; i-- > 0; ) {
+        if (g_ascii_tolower(candidate[i]) == q[q_index - 1] && --q_index == 0) {
+            start = i;
+            break;
+        }
+    }
+
+    // 3. Score the window. Character classes come from the original case.
+    const gchar *classes = cased ? cased : candidate;
+    gint total = 0;
+    gint consecutive = 0;
+    gint first_bonus = 0;
+    gboolean in_gap = FALSE;
+    CharClass prev = start > 0 ? char_class(classes[start - 1]) : CHAR_NONWORD;
+
+    for (gsize i = start; i < end; i++) {
+        CharClass cls = char_class(classes[i]);
+        if (q_index < q_len && g_ascii_tolower(candidate[i]) == q[q_index]) {
+            gint bonus = char_bonus(prev, cls);
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            } else {
+                // A boundary inside a run starts a new chunk.
+                if (bonus >= BONUS_BOUNDARY) first_bonus = bonus;
+                bonus = MAX(bonus, MAX(first_bonus, BONUS_CONSECUTIVE));
+            }
+            total += SCORE_MATCH + (q_index == 0 ? bonus * BONUS_FIRST_CHAR_MULTIPLIER : bonus);
+            if (positions) positions[q_index] = i;
+            q_index++;
+            consecutive++;
+            in_gap = FALSE;
+        } else {
+            total += in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            in_gap = TRUE;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        prev = cls;
+    }
+
+    *score = total;
+    return TRUE;
+}
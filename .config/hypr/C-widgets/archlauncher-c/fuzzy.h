@@ -0,0 +1,35 @@
+#ifndef FUZZY_H
+#define FUZZY_H
+
+#include <glib.h>
+
+// Longest query (in bytes) the matcher looks at; longer input is truncated.
+#define FUZZY_MAX_QUERY 64
+
+// A search query, prepared once per keystroke and reused for every candidate.
+typedef struct {
+    gchar text[FUZZY_MAX_QUERY + 1]; // ASCII-lowercased query
+    gsize len;
+    guint64 mask;                    // fuzzy_char_mask() of the query
+} FuzzyQuery;
+
+// Returns a 64-bit set of the (ASCII case-insensitive) bytes occurring in str.
+// A candidate can only match if its mask contains every bit of the query's
+// mask, which rejects most candidates without looking at their text.
+guint64 fuzzy_char_mask(const gchar *str);
+
+// Prepares query for fuzzy_match().
+void fuzzy_query_init(FuzzyQuery *query, const gchar *text);
+
+// Matches the query as an in-order subsequence of candidate, fzf-style: every
+// matched char scores, with bonuses for word boundaries, camelCase humps and
+// contiguous runs, and penalties for gaps. Returns FALSE if there is no match.
+// Search keys are folded, so the humps are read from cased: the original
+// text, byte for byte aligned with candidate, or NULL to score without them.
+// If positions is not NULL it must hold query->len entries and receives the
+// byte offsets of the matched chars in candidate. An empty query matches
+// everything with a score of 0.
+gboolean fuzzy_match(const FuzzyQuery *query, const gchar *candidate, const gchar *cased,
+                     guint64 candidate_mask, gint *score, guint *positions);
+
+#endif // FUZZY_H
@@ -0,0 +1,194 @@
+#include "history.h"
+#include "app_info.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// On-disk Format
+// -----------------------------------------------------------------------------
+//
+// header | offsets[n_lines] | string pool
+//
+// offsets[i] is the byte offset of line i in the pool, which holds the
+// NUL-terminated lines back to back. Lines are unique and sorted by strcmp(),
+// so a lookup is a binary search straight on the mapping.
+
+#define HISTORY_MAGIC   0x54534843u // "CHST"
+#define HISTORY_VERSION 1
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 n_lines;
+    guint32 pool_size;
+} HistoryHeader;
+
+struct _History {
+    GMappedFile *mapped;  // NULL for an empty history
+    const guint32 *offsets;
+    const gchar *pool;
+    guint n_lines;
+};
+
+static gint compare_lines(gconstpointer a, gconstpointer b) {
+    return strcmp(*(const gchar * const *)a, *(const gchar * const *)b);
+}
+
+// Returns the index of the first line not sorting before line.
+static guint lower_bound(History *history, const gchar *line) {
+    guint low = 0;
+    guint high = history->n_lines;
+    while (low < high) {
+        guint mid = low + (high - low) / 2;
+        if (strcmp(history_get_line(history, mid), line) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Maps the file and checks that every offset lands inside the pool.
+static void map_history(History *history, const gchar *path) {
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, NULL);
+    if (!mapped) return;
+
+    const gchar *contents = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    const HistoryHeader *header = (const HistoryHeader *)contents;
+    if (length < sizeof(HistoryHeader) || header->magic != HISTORY_MAGIC || header->version != HISTORY_VERSION ||
+        sizeof(HistoryHeader) + (guint64)header->n_lines * sizeof(guint32) + header->pool_size != length) {
+        g_mapped_file_unref(mapped);
+        return;
+    }
+
+    const guint32 *offsets = (const guint32 *)(contents + sizeof(HistoryHeader));
+    const gchar *pool = (const gchar *)(offsets + header->n_lines);
+    if (header->n_lines > 0 && (header->pool_size == 0 || pool[header->pool_size - 1] != '\0')) {
+        g_mapped_file_unref(mapped);
+        return;
+    }
+    for (guint32 i = 0; i < header->n_lines; i++) {
+        if (offsets[i] >= header->pool_size) {
+            g_mapped_file_unref(mapped);
+            return;
+        }
+    }
+
+    history->mapped = mapped;
+    history->offsets = offsets;
+    history->pool = pool;
+    history->n_lines = header->n_lines;
+}
+
+// Writes sorted, unique lines as a new history file.
+static gboolean write_history(GPtrArray *lines) {
+    GString *pool = g_string_new(NULL);
+    GArray *offsets = g_array_sized_new(FALSE, FALSE, sizeof(guint32), lines->len);
+    for (guint i = 0; i < lines->len; i++) {
+        const gchar *line = g_ptr_array_index(lines, i);
+        guint32 offset = pool->len;
+        g_array_append_val(offsets, offset);
+        g_string_append_len(pool, line, strlen(line) + 1);
+    }
+
+    HistoryHeader header = { HISTORY_MAGIC, HISTORY_VERSION, offsets->len, pool->len };
+    GByteArray *buffer = g_byte_array_new();
+    g_byte_array_append(buffer, (const guint8 *)&header, sizeof(header));
+    g_byte_array_append(buffer, (const guint8 *)offsets->data, offsets->len * sizeof(guint32));
+    g_byte_array_append(buffer, (const guint8 *)pool->str, pool->len);
+
+    // Written to a temporary file and renamed into place, so a running
+    // launcher keeps its mapping of the old file intact.
+    gchar *path = launcher_cache_path(HISTORY_FILE);
+    GError *error = NULL;
+    gboolean ok = g_file_set_contents(path, (const gchar *)buffer->data, buffer->len, &error);
+    if (!ok) {
+        g_warning("Failed to write command history: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_free(path);
+    g_byte_array_unref(buffer);
+    g_array_unref(offsets);
+    g_string_free(pool, TRUE);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+History* history_load(void) {
+    History *history = g_new0(History, 1);
+    gchar *path = launcher_cache_path(HISTORY_FILE);
+    map_history(history, path);
+    g_free(path);
+    return history;
+}
+
+guint history_get_n_lines(History *history) {
+    return history->n_lines;
+}
+
+const gchar* history_get_line(History *history, guint i) {
+    return history->pool + history->offsets[i];
+}
+
+void history_add(const gchar *line) {
+    gsize length = strlen(line);
+    if (length == 0 || length > HISTORY_MAX_LINE) return;
+
+    History *history = history_load();
+    guint position = lower_bound(history, line);
+    if (position < history->n_lines && strcmp(history_get_line(history, position), line) == 0) {
+        history_free(history);
+        return;
+    }
+
+    // The new line goes where the binary search found its place, so the
+    // result is sorted without sorting anything.
+    GPtrArray *lines = g_ptr_array_sized_new(history->n_lines + 1);
+    for (guint i = 0; i < position; i++) {
+        g_ptr_array_add(lines, (gpointer)history_get_line(history, i));
+    }
+    g_ptr_array_add(lines, (gpointer)line);
+    for (guint i = position; i < history->n_lines; i++) {
+        g_ptr_array_add(lines, (gpointer)history_get_line(history, i));
+    }
+    write_history(lines);
+
+    g_ptr_array_unref(lines);
+    history_free(history);
+}
+
+gboolean history_save(GPtrArray *lines) {
+    GPtrArray *sorted = g_ptr_array_sized_new(lines->len);
+    for (guint i = 0; i < lines->len; i++) {
+        const gchar *line = g_ptr_array_index(lines, i);
+        gsize length = strlen(line);
+        if (length > 0 && length <= HISTORY_MAX_LINE) {
+            g_ptr_array_add(sorted, (gpointer)line);
+        }
+    }
+    g_ptr_array_sort(sorted, compare_lines);
+
+    // Drop duplicates, now neighbours.
+    guint n_unique = 0;
+    for (guint i = 0; i < sorted->len; i++) {
+        if (n_unique == 0 || strcmp(sorted->pdata[n_unique - 1], sorted->pdata[i]) != 0) {
+            sorted->pdata[n_unique++] = sorted->pdata[i];
+        }
+    }
+    g_ptr_array_set_size(sorted, n_unique);
+
+    gboolean ok = write_history(sorted);
+    g_ptr_array_unref(sorted);
+    return ok;
+}
+
+void history_free(History *history) {
+    if (!history) return;
+    if (history->mapped) g_mapped_file_unref(history->mapped);
+    g_free(history);
+}
@@ -0,0 +1,34 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <glib.h>
+
+// Name of the command line history inside ~/.cache/cachy/
+#define HISTORY_FILE "run_history.bin"
+
+// Longest command line worth remembering, in bytes
+#define HISTORY_MAX_LINE 4096
+
+// The unique command lines run from the launcher, memory-mapped and sorted by
+// strcmp(), which is also compare_apps() order.
+typedef struct _History History;
+
+// Maps the history file. Never returns NULL; a missing or unreadable file
+// just gives an empty history.
+History* history_load(void);
+
+guint history_get_n_lines(History *history);
+
+// Line i in sorted order; the string belongs to the mapping.
+const gchar* history_get_line(History *history, guint i);
+
+// Adds line to the history file unless it is already there. Only a new line
+// rewrites the file; running a remembered line again costs nothing here.
+void history_add(const gchar *line);
+
+// Replaces the history with lines (in any order, duplicates allowed).
+gboolean history_save(GPtrArray *lines);
+
+void history_free(History *history);
+
+#endif // HISTORY_H
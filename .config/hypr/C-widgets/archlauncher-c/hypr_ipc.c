@@ -0,0 +1,366 @@
+#include "hypr_ipc.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Hyprland answers at once; this only guards against a wedged compositor.
+#define REPLY_TIMEOUT_MS 1000
+#define READ_CHUNK 8192
+// Deeper JSON than any clients reply has is treated as garbage.
+#define PARSER_MAX_DEPTH 16
+
+typedef void (*ReplyChunkFunc)(const gchar *chunk, gsize length, gpointer user_data);
+
+// -----------------------------------------------------------------------------
+// Socket
+// -----------------------------------------------------------------------------
+
+static gchar* socket_path(void) {
+    const gchar *signature = g_getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (!signature || signature[0] == '\0') return NULL;
+
+    gchar *path = g_build_filename(g_get_user_runtime_dir(), "hypr", signature, ".socket.sock", NULL);
+    if (!g_file_test(path, G_FILE_TEST_EXISTS)) {
+        // Hyprland before 0.40 kept its sockets in /tmp.
+        g_free(path);
+        path = g_build_filename(g_get_tmp_dir(), "hypr", signature, ".socket.sock", NULL);
+    }
+    return path;
+}
+
+// Hyprland reads one request per connection, writes the reply and closes it,
+// so every request connects anew. The reply is handed to func as it arrives.
+static gboolean send_request(const gchar *request, ReplyChunkFunc func, gpointer user_data, GError **error) {
+    gchar *path = socket_path();
+    if (!path) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOENT, "Not running under Hyprland");
+        return FALSE;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NAMETOOLONG, "Hyprland socket path is too long: %s", path);
+        g_free(path);
+        return FALSE;
+    }
+    strcpy(addr.sun_path, path);
+    g_free(path);
+
+    gint fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        gint saved_errno = errno;
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "Failed to connect to Hyprland: %s", g_strerror(saved_errno));
+        if (fd >= 0) close(fd);
+        return FALSE;
+    }
+    struct timeval timeout = { REPLY_TIMEOUT_MS / 1000, (REPLY_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    gsize length = strlen(request);
+    gsize written = 0;
+    while (written < length) {
+        gssize n = send(fd, request + written, length - written, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+
+    gboolean ok = written == length;
+    gchar buffer[READ_CHUNK];
+    while (ok) {
+        gssize n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) ok = FALSE;
+        if (n <= 0) break;
+        func(buffer, n, user_data);
+    }
+    if (!ok) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "Hyprland request \"%s\" failed: %s", request, g_strerror(errno));
+    }
+    close(fd);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Streaming Clients Parser
+// -----------------------------------------------------------------------------
+//
+// A byte-at-a-time JSON state machine that never holds more than the string
+// it is reading. Clients are the objects at depth 2 (inside the top-level
+// array); each one is complete, and appended, as soon as its '}' arrives.
+
+typedef enum {
+    PARSE_VALUE,    // Between tokens
+    PARSE_STRING,
+    PARSE_ESCAPE,   // After a backslash in a string
+    PARSE_UNICODE,  // Inside the four hex digits of a \u escape
+    PARSE_LITERAL   // A number, true, false or null
+} ParseState;
+
+typedef struct {
+    ParseState state;
+    gchar stack[PARSER_MAX_DEPTH + 1];   // '[' or '{' of every open container, from 1
+    gchar *keys[PARSER_MAX_DEPTH + 1];   // The current member name of every open object
+    gint depth;
+    gboolean expect_key;                 // The next string in this object is a member name
+    GString *token;
+    guint32 unicode;                     // The \u escape read so far
+    gint unicode_digits;
+    guint32 high_surrogate;              // First half of a surrogate pair, 0 if none
+    HyprClient *client;                  // The client object being read
+    GPtrArray *clients;
+    gboolean failed;
+} ClientParser;
+
+void hypr_client_free(gpointer data) {
+    HyprClient *client = data;
+    if (!client) return;
+    g_free(client->address);
+    g_free(client->class_name);
+    g_free(client->title);
+    g_free(client->workspace);
+    g_free(client);
+}
+
+// Stores a scalar member of the client object, or of its workspace object.
+static void assign_field(ClientParser *parser, const gchar *value, gboolean is_string) {
+    if (!parser->client) return;
+    const gchar *key = parser->keys[parser->depth];
+    if (parser->depth == 2) {
+        if (is_string && g_strcmp0(key, "address") == 0) {
+            g_free(parser->client->address);
+            parser->client->address = g_strdup(value);
+        } else if (is_string && g_strcmp0(key, "class") == 0) {
+            g_free(parser->client->class_name);
+            parser->client->class_name = g_strdup(value);
+        } else if (is_string && g_strcmp0(key, "title") == 0) {
+            g_free(parser->client->title);
+            parser->client->title = g_strdup(value);
+        } else if (!is_string && g_strcmp0(key, "focusHistoryID") == 0) {
+            parser->client->focus_history_id = (gint)g_ascii_strtoll(value, NULL, 10);
+        } else if (!is_string && g_strcmp0(key, "mapped") == 0) {
+            parser->client->mapped = g_strcmp0(value, "true") == 0;
+        } else if (!is_string && g_strcmp0(key, "hidden") == 0) {
+            parser->client->hidden = g_strcmp0(value, "true") == 0;
+        }
+    } else if (parser->depth == 3 && is_string && g_strcmp0(parser->keys[2], "workspace") == 0 &&
+               g_strcmp0(key, "name") == 0) {
+        g_free(parser->client->workspace);
+        parser->client->workspace = g_strdup(value);
+    }
+}
+
+// A complete string or literal: a member name or a value.
+static void end_scalar(ClientParser *parser, gboolean is_string) {
+    const gchar *text = parser->token->str;
+    if (parser->depth > 0 && parser->stack[parser->depth] == '{') {
+        if (parser->expect_key) {
+            if (!is_string) {
+                parser->failed = TRUE;
+                return;
+            }
+            g_free(parser->keys[parser->depth]);
+            parser->keys[parser->depth] = g_strdup(text);
+            return;
+        }
+        assign_field(parser, text, is_string);
+    }
+}
+
+static void open_container(ClientParser *parser, gchar c) {
+    if (parser->depth == PARSER_MAX_DEPTH || (parser->depth == 0 && c != '[')) {
+        parser->failed = TRUE;
+        return;
+    }
+    parser->depth++;
+    parser->stack[parser->depth] = c;
+    g_clear_pointer(&parser->keys[parser->depth], g_free);
+    parser->expect_key = c == '{';
+    if (c == '{' && parser->depth == 2) {
+        parser->client = g_new0(HyprClient, 1);
+    }
+}
+
+static void close_container(ClientParser *parser, gchar c) {
+    gchar open = c == '}' ? '{' : '[';
+    if (parser->depth == 0 || parser->stack[parser->depth] != open) {
+        parser->failed = TRUE;
+        return;
+    }
+    if (c == '}' && parser->depth == 2 && parser->client) {
+        if (parser->client->address) {
+            g_ptr_array_add(parser->clients, parser->client);
+        } else {
+            hypr_client_free(parser->client);
+        }
+        parser->client = NULL;
+    }
+    g_clear_pointer(&parser->keys[parser->depth], g_free);
+    parser->depth--;
+    parser->expect_key = FALSE;
+}
+
+// Appends the code point of a finished \u escape, pairing UTF-16 surrogates.
+static void end_unicode_escape(ClientParser *parser) {
+    guint32 c = parser->unicode;
+    if (c >= 0xd800 && c <= 0xdbff) {
+        parser->high_surrogate = c;
+        return;
+    }
+    if (c >= 0xdc00 && c <= 0xdfff) {
+        if (!parser->high_surrogate) return;
+        c = 0x10000 + ((parser->high_surrogate - 0xd800) << 10) + (c - 0xdc00);
+    }
+    parser->high_surrogate = 0;
+    g_string_append_unichar(parser->token, c);
+}
+
+static void parse_char(ClientParser *parser, gchar c) {
+    switch (parser->state) {
+        case PARSE_STRING:
+            if (c == '\\') {
+                parser->state = PARSE_ESCAPE;
+            } else if (c == '"') {
+                parser->state = PARSE_VALUE;
+                end_scalar(parser, TRUE);
+            } else {
+                g_string_append_c(parser->token, c);
+            }
+            return;
+
+        case PARSE_ESCAPE:
+            parser->state = PARSE_STRING;
+            switch (c) {
+                case 'n': g_string_append_c(parser->token, '\n'); break;
+                case 't': g_string_append_c(parser->token, '\t'); break;
+                case 'r': g_string_append_c(parser->token, '\r'); break;
+                case 'b': g_string_append_c(parser->token, '\b'); break;
+                case 'f': g_string_append_c(parser->token, '\f'); break;
+                case 'u':
+                    parser->state = PARSE_UNICODE;
+                    parser->unicode = 0;
+                    parser->unicode_digits = 0;
+                    break;
+                default: g_string_append_c(parser->token, c); break;
+            }
+            return;
+
+        case PARSE_UNICODE: {
+            gint digit = g_ascii_xdigit_value(c);
+            if (digit < 0) {
+                parser->failed = TRUE;
+                return;
+            }
+            parser->unicode = parser->unicode << 4 | digit;
+            if (++parser->unicode_digits == 4) {
+                parser->state = PARSE_STRING;
+                end_unicode_escape(parser);
+            }
+            return;
+        }
+
+        case PARSE_LITERAL:
+            if (g_ascii_isalnum(c) || c == '-' || c == '+' || c == '.') {
+                g_string_append_c(parser->token, c);
+                return;
+            }
+            parser->state = PARSE_VALUE;
+            end_scalar(parser, FALSE);
+            if (parser->failed) return;
+            break; // c ends the literal and still needs handling below
+
+        case PARSE_VALUE:
+            break;
+    }
+
+    switch (c) {
+        case ' ': case '\t': case '\n': case '\r':
+            break;
+        case '{': case '[':
+            open_container(parser, c);
+            break;
+        case '}': case ']':
+            close_container(parser, c);
+            break;
+        case ':':
+            parser->expect_key = FALSE;
+            break;
+        case ',':
+            parser->expect_key = parser->depth > 0 && parser->stack[parser->depth] == '{';
+            break;
+        case '"':
+            g_string_truncate(parser->token, 0);
+            parser->high_surrogate = 0;
+            parser->state = PARSE_STRING;
+            break;
+        default:
+            g_string_truncate(parser->token, 0);
+            g_string_append_c(parser->token, c);
+            parser->state = PARSE_LITERAL;
+            break;
+    }
+}
+
+static void parse_chunk(const gchar *chunk, gsize length, gpointer user_data) {
+    ClientParser *parser = user_data;
+    for (gsize i = 0; i < length && !parser->failed; i++) {
+        parse_char(parser, chunk[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+GPtrArray* hypr_ipc_get_clients(void) {
+    ClientParser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.token = g_string_new(NULL);
+    parser.clients = g_ptr_array_new_with_free_func(hypr_client_free);
+
+    GError *error = NULL;
+    gboolean ok = send_request("j/clients", parse_chunk, &parser, &error);
+    if (!ok) {
+        g_debug("%s", error->message);
+        g_error_free(error);
+    } else if (parser.failed || parser.depth != 0) {
+        g_warning("Hyprland sent an unreadable client list");
+        ok = FALSE;
+    }
+
+    hypr_client_free(parser.client);
+    for (gint i = 0; i <= PARSER_MAX_DEPTH; i++) {
+        g_free(parser.keys[i]);
+    }
+    g_string_free(parser.token, TRUE);
+    if (!ok) {
+        g_ptr_array_unref(parser.clients);
+        return NULL;
+    }
+    return parser.clients;
+}
+
+static void collect_reply(const gchar *chunk, gsize length, gpointer user_data) {
+    g_string_append_len(user_data, chunk, length);
+}
+
+gboolean hypr_ipc_focus_window(const gchar *address, GError **error) {
+    gchar *request = g_strdup_printf("dispatch focuswindow address:%s", address);
+    GString *reply = g_string_new(NULL);
+    gboolean ok = send_request(request, collect_reply, reply, error);
+    if (ok && g_strcmp0(g_strstrip(reply->str), "ok") != 0) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "Hyprland refused to focus %s: %s", address, reply->str);
+        ok = FALSE;
+    }
+    g_string_free(reply, TRUE);
+    g_free(request);
+    return ok;
+}
@@ -0,0 +1,33 @@
+#ifndef HYPR_IPC_H
+#define HYPR_IPC_H
+
+#include <glib.h>
+
+// Talks to Hyprland's request socket,
+// $XDG_RUNTIME_DIR/hypr/$HYPRLAND_INSTANCE_SIGNATURE/.socket.sock, without
+// going through hyprctl. Pointing both variables at another directory is
+// enough to run against a fake server.
+
+// One window as listed by "j/clients"
+typedef struct {
+    gchar *address;        // "0x..." as the dispatchers take it
+    gchar *class_name;
+    gchar *title;
+    gchar *workspace;      // Workspace name
+    gint focus_history_id; // 0 for the focused window, 1 for the one before, ...
+    gboolean mapped;
+    gboolean hidden;
+} HyprClient;
+
+// Fetches the client list with a single request and parses the reply as it
+// streams in. Returns an array of HyprClient in the order Hyprland listed
+// them, or NULL if Hyprland could not be reached or answered garbage.
+GPtrArray* hypr_ipc_get_clients(void);
+
+// Focuses the window with the given address. Returns FALSE and sets error if
+// the request failed or Hyprland refused it.
+gboolean hypr_ipc_focus_window(const gchar *address, GError **error);
+
+void hypr_client_free(gpointer data);
+
+#endif // HYPR_IPC_H
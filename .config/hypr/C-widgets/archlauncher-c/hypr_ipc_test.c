@@ -0,0 +1,227 @@
+// Tests of the Hyprland IPC client against a fake Hyprland: canned replies
+// served over $XDG_RUNTIME_DIR/hypr/<signature>/.socket.sock, with both
+// variables pointing into a temporary directory.
+//
+//   meson test hypr_ipc
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "hypr_ipc.h"
+
+#define SIGNATURE "test_signature"
+// Pause after every write of a split reply, so the client reads each on its own
+#define SPLIT_WRITE_DELAY_US 200
+
+// Two clients as Hyprland lists them, trimmed, with escapes in the first
+// title and an object nested inside a client that holds keys of its own.
+static const gchar clients_reply[] =
+    "[{\"address\": \"0x55d1a2b0\", \"mapped\": true, \"hidden\": false, \"at\": [0, 24],"
+    " \"size\": [1920, 1056], \"workspace\": {\"id\": 2, \"name\": \"web\"}, \"floating\": false,"
+    " \"class\": \"firefox\", \"title\": \"Say \\\"hi\\\" \\\\ caf\\u00e9 \\ud83d\\ude00\\n\","
+    " \"grabbed\": {\"address\": \"0xdead\", \"title\": \"inner\", \"workspace\": {\"name\": \"deep\"}},"
+    " \"grouped\": [], \"tags\": [\"a\", \"b\"], \"swallowing\": \"0x0\", \"focusHistoryID\": 1},\n"
+    " {\"address\": \"0x55d1c3d0\", \"mapped\": true, \"hidden\": true,"
+    " \"workspace\": {\"id\": -98, \"name\": \"special:magic\"}, \"class\": \"kitty\", \"title\": \"~\","
+    " \"focusHistoryID\": 0}]";
+
+static gint listen_fd = -1;
+
+// One connection to the fake Hyprland
+typedef struct {
+    const gchar *reply;
+    gsize chunk;    // Bytes per write, 0 to write the reply at once
+    gchar *request; // What the client sent
+} Exchange;
+
+// -----------------------------------------------------------------------------
+// Fake Hyprland
+// -----------------------------------------------------------------------------
+
+// Like Hyprland: reads one request, writes the reply and closes the connection.
+static gpointer serve_one(gpointer user_data) {
+    Exchange *exchange = user_data;
+    gint fd = accept(listen_fd, NULL, NULL);
+    g_assert_cmpint(fd, >=, 0);
+
+    gchar buffer[256];
+    gssize n = read(fd, buffer, sizeof(buffer));
+    g_assert_cmpint(n, >, 0);
+    exchange->request = g_strndup(buffer, n);
+
+    gsize length = strlen(exchange->reply);
+    gsize chunk = exchange->chunk ? exchange->chunk : length;
+    for (gsize offset = 0; offset < length; offset += chunk) {
+        gsize size = MIN(chunk, length - offset);
+        g_assert_cmpint(write(fd, exchange->reply + offset, size), ==, (gssize)size);
+        if (exchange->chunk) g_usleep(SPLIT_WRITE_DELAY_US);
+    }
+    close(fd);
+    return NULL;
+}
+
+static GThread* serve(Exchange *exchange, const gchar *reply, gsize chunk) {
+    exchange->reply = reply;
+    exchange->chunk = chunk;
+    exchange->request = NULL;
+    return g_thread_new("fake-hyprland", serve_one, exchange);
+}
+
+// Puts a listening socket where hypr_ipc looks for Hyprland's. Returns the
+// temporary runtime directory.
+static gchar* start_fake_hyprland(void) {
+    gchar *runtime_dir = g_dir_make_tmp("hypr-ipc-test-XXXXXX", NULL);
+    g_assert_nonnull(runtime_dir);
+    gchar *socket_dir = g_build_filename(runtime_dir, "hypr", SIGNATURE, NULL);
+    g_assert_cmpint(g_mkdir_with_parents(socket_dir, 0700), ==, 0);
+    gchar *path = g_build_filename(socket_dir, ".socket.sock", NULL);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    g_assert_cmpuint(strlen(path), <, sizeof(addr.sun_path));
+    strcpy(addr.sun_path, path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    g_assert_cmpint(listen_fd, >=, 0);
+    g_assert_cmpint(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)), ==, 0);
+    g_assert_cmpint(listen(listen_fd, 1), ==, 0);
+
+    g_setenv("XDG_RUNTIME_DIR", runtime_dir, TRUE);
+    g_setenv("HYPRLAND_INSTANCE_SIGNATURE", SIGNATURE, TRUE);
+    g_free(path);
+    g_free(socket_dir);
+    return runtime_dir;
+}
+
+static void stop_fake_hyprland(gchar *runtime_dir) {
+    close(listen_fd);
+    gchar *socket_dir = g_build_filename(runtime_dir, "hypr", SIGNATURE, NULL);
+    gchar *path = g_build_filename(socket_dir, ".socket.sock", NULL);
+    gchar *hypr_dir = g_build_filename(runtime_dir, "hypr", NULL);
+    g_remove(path);
+    g_rmdir(socket_dir);
+    g_rmdir(hypr_dir);
+    g_rmdir(runtime_dir);
+    g_free(hypr_dir);
+    g_free(path);
+    g_free(socket_dir);
+    g_free(runtime_dir);
+}
+
+// -----------------------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------------------
+
+// Fetches the clients from a server writing clients_reply chunk bytes at a time.
+static GPtrArray* get_clients(gsize chunk) {
+    Exchange exchange;
+    GThread *thread = serve(&exchange, clients_reply, chunk);
+    GPtrArray *clients = hypr_ipc_get_clients();
+    g_assert_nonnull(clients);
+    g_thread_join(thread);
+    g_assert_cmpstr(exchange.request, ==, "j/clients");
+    g_free(exchange.request);
+    return clients;
+}
+
+static void check_clients(GPtrArray *clients) {
+    g_assert_cmpuint(clients->len, ==, 2);
+
+    HyprClient *browser = g_ptr_array_index(clients, 0);
+    g_assert_cmpstr(browser->address, ==, "0x55d1a2b0");
+    g_assert_cmpstr(browser->class_name, ==, "firefox");
+    g_assert_cmpstr(browser->title, ==, "Say \"hi\" \\ caf\xc3\xa9 \xf0\x9f\x98\x80\n");
+    g_assert_cmpstr(browser->workspace, ==, "web");
+    g_assert_cmpint(browser->focus_history_id, ==, 1);
+    g_assert_true(browser->mapped);
+    g_assert_false(browser->hidden);
+
+    HyprClient *terminal = g_ptr_array_index(clients, 1);
+    g_assert_cmpstr(terminal->address, ==, "0x55d1c3d0");
+    g_assert_cmpstr(terminal->class_name, ==, "kitty");
+    g_assert_cmpstr(terminal->title, ==, "~");
+    g_assert_cmpstr(terminal->workspace, ==, "special:magic");
+    g_assert_cmpint(terminal->focus_history_id, ==, 0);
+    g_assert_true(terminal->mapped);
+    g_assert_true(terminal->hidden);
+}
+
+// Escapes and members of nested objects, with the reply read in one go.
+static void test_clients_whole(void) {
+    GPtrArray *clients = get_clients(0);
+    check_clients(clients);
+    g_ptr_array_unref(clients);
+}
+
+// The same reply a byte per read, so every escape, literal and string is split.
+static void test_clients_split(void) {
+    GPtrArray *clients = get_clients(1);
+    check_clients(clients);
+    g_ptr_array_unref(clients);
+}
+
+// Splits that fall at uneven places of the tokens.
+static void test_clients_split_uneven(void) {
+    GPtrArray *clients = get_clients(7);
+    check_clients(clients);
+    g_ptr_array_unref(clients);
+}
+
+static void expect_unreadable(const gchar *reply) {
+    Exchange exchange;
+    GThread *thread = serve(&exchange, reply, 0);
+    g_test_expect_message(NULL, G_LOG_LEVEL_WARNING, "*unreadable client list*");
+    g_assert_null(hypr_ipc_get_clients());
+    g_test_assert_expected_messages();
+    g_thread_join(thread);
+    g_free(exchange.request);
+}
+
+static void test_clients_garbage(void) {
+    expect_unreadable("[{\"address\": \"0x55d1a2b0\", \"title\": \"cut off\"}");
+    expect_unreadable("{\"address\": \"0x55d1a2b0\"}");
+    expect_unreadable("[{\"address\": \"0x55d1a2b0\", \"title\": \"\\uzzzz\"}]");
+}
+
+static void test_focus_window(void) {
+    Exchange exchange;
+    GThread *thread = serve(&exchange, "ok", 0);
+    GError *error = NULL;
+    g_assert_true(hypr_ipc_focus_window("0x55d1a2b0", &error));
+    g_assert_no_error(error);
+    g_thread_join(thread);
+    g_assert_cmpstr(exchange.request, ==, "dispatch focuswindow address:0x55d1a2b0");
+    g_free(exchange.request);
+}
+
+static void test_focus_window_refused(void) {
+    Exchange exchange;
+    GThread *thread = serve(&exchange, "No such window found", 0);
+    GError *error = NULL;
+    g_assert_false(hypr_ipc_focus_window("0x55d1ffff", &error));
+    g_assert_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED);
+    g_error_free(error);
+    g_thread_join(thread);
+    g_assert_cmpstr(exchange.request, ==, "dispatch focuswindow address:0x55d1ffff");
+    g_free(exchange.request);
+}
+
+int main(int argc, char *argv[]) {
+    // Before anything asks GLib for the runtime directory, which it caches.
+    gchar *runtime_dir = start_fake_hyprland();
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/hypr-ipc/clients/whole", test_clients_whole);
+    g_test_add_func("/hypr-ipc/clients/split", test_clients_split);
+    g_test_add_func("/hypr-ipc/clients/split-uneven", test_clients_split_uneven);
+    g_test_add_func("/hypr-ipc/clients/garbage", test_clients_garbage);
+    g_test_add_func("/hypr-ipc/focus-window", test_focus_window);
+    g_test_add_func("/hypr-ipc/focus-window/refused", test_focus_window_refused);
+    gint status = g_test_run();
+
+    stop_fake_hyprland(runtime_dir);
+    return status;
+}
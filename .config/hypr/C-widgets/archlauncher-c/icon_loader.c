@@ -0,0 +1,287 @@
+#include "icon_loader.h"
+#include "app_info.h"
+#include <string.h>
+
+// Icon decoding is mostly I/O and SVG rendering; a couple of threads is plenty.
+#define ICON_THREADS 2
+
+// -----------------------------------------------------------------------------
+// On-disk Format
+// -----------------------------------------------------------------------------
+//
+// One file per icon, named after a hash of "<icon>\n<theme>\n<size>", holding
+// an IconCacheHeader followed by the raw RGBA rows, so a cache hit is a single
+// read with no PNG or SVG decoding.
+
+#define ICON_CACHE_MAGIC 0x4f434943u // "CICO"
+
+typedef struct {
+    guint32 magic;
+    guint32 width;
+    guint32 height;
+    guint32 rowstride;
+} IconCacheHeader;
+
+struct _IconLoader {
+    gint ref_count;
+    gint closed;             // Set once icon_loader_free() ran
+    gint pixel_size;
+    gboolean skip_disk_cache;
+    gchar *theme_name;
+    gchar *cache_dir;
+    IconReadyFunc ready;
+    gpointer user_data;
+
+    GThreadPool *pool;
+    GHashTable *icons;       // Main thread only: GIcon -> GdkPixbuf, NULL if it failed
+    GHashTable *pending;     // Main thread only: GIcon queued but not delivered yet
+    GAsyncQueue *done;       // IconJob, loaded and waiting for the main thread
+    gint delivery_queued;    // An idle callback is already draining done
+};
+
+typedef struct {
+    GIcon *icon;
+    gchar *filename;         // The icon's file as the theme resolved it, NULL if it has none
+    GdkPixbuf *pixbuf;       // Set by the worker, NULL if the icon could not be loaded
+} IconJob;
+
+static IconLoader* icon_loader_ref(IconLoader *loader) {
+    g_atomic_int_inc(&loader->ref_count);
+    return loader;
+}
+
+static void icon_job_free(gpointer data) {
+    IconJob *job = data;
+    g_object_unref(job->icon);
+    g_free(job->filename);
+    if (job->pixbuf) g_object_unref(job->pixbuf);
+    g_free(job);
+}
+
+static void clear_pixbuf(gpointer data) {
+    if (data) g_object_unref(data);
+}
+
+static void icon_loader_unref(IconLoader *loader) {
+    if (!g_atomic_int_dec_and_test(&loader->ref_count)) return;
+    IconJob *job;
+    while ((job = g_async_queue_try_pop(loader->done))) {
+        icon_job_free(job);
+    }
+    g_async_queue_unref(loader->done);
+    g_free(loader->theme_name);
+    g_free(loader->cache_dir);
+    g_free(loader);
+}
+
+// -----------------------------------------------------------------------------
+// Disk Cache
+// -----------------------------------------------------------------------------
+
+static gchar* cache_file_path(IconLoader *loader, GIcon *icon) {
+    gchar *icon_str = g_icon_to_string(icon);
+    if (!icon_str) return NULL;
+
+    gchar *key = g_strdup_printf("%s\n%s\n%d", icon_str, loader->theme_name, loader->pixel_size);
+    gchar *hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+    gchar *path = g_build_filename(loader->cache_dir, hash, NULL);
+    g_free(hash);
+    g_free(key);
+    g_free(icon_str);
+    return path;
+}
+
+static GdkPixbuf* read_cached_icon(const gchar *path) {
+    gchar *contents;
+    gsize length;
+    if (!g_file_get_contents(path, &contents, &length, NULL)) return NULL;
+
+    IconCacheHeader header;
+    if (length < sizeof(header)) {
+        g_free(contents);
+        return NULL;
+    }
+    memcpy(&header, contents, sizeof(header));
+    if (header.magic != ICON_CACHE_MAGIC || header.width == 0 || header.height == 0 ||
+        header.rowstride < header.width * 4 ||
+        length - sizeof(header) != (gsize)header.rowstride * header.height) {
+        g_free(contents);
+        return NULL;
+    }
+
+    GBytes *bytes = g_bytes_new_take(contents, length);
+    GBytes *pixels = g_bytes_new_from_bytes(bytes, sizeof(header), length - sizeof(header));
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_bytes(pixels, GDK_COLORSPACE_RGB, TRUE, 8,
+                                                  header.width, header.height, header.rowstride);
+    g_bytes_unref(pixels);
+    g_bytes_unref(bytes);
+    return pixbuf;
+}
+
+static void write_cached_icon(const gchar *path, GdkPixbuf *pixbuf) {
+    IconCacheHeader header;
+    header.magic = ICON_CACHE_MAGIC;
+    header.width = gdk_pixbuf_get_width(pixbuf);
+    header.height = gdk_pixbuf_get_height(pixbuf);
+    header.rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+
+    // The last row of a pixbuf is not padded to the rowstride; the file is.
+    gsize pixels_size = (gsize)header.rowstride * header.height;
+    gsize byte_length = gdk_pixbuf_get_byte_length(pixbuf);
+    GString *out = g_string_sized_new(sizeof(header) + pixels_size);
+    g_string_append_len(out, (const gchar *)&header, sizeof(header));
+    g_string_append_len(out, (const gchar *)gdk_pixbuf_read_pixels(pixbuf), byte_length);
+    while (out->len < sizeof(header) + pixels_size) {
+        g_string_append_c(out, '\0');
+    }
+
+    GError *error = NULL;
+    if (!g_file_set_contents(path, out->str, out->len, &error)) {
+        g_debug("Failed to cache icon %s: %s", path, error->message);
+        g_error_free(error);
+    }
+    g_string_free(out, TRUE);
+}
+
+// -----------------------------------------------------------------------------
+// Worker Threads
+// -----------------------------------------------------------------------------
+
+// The cache format and gdk_pixbuf_new_from_bytes() above assume RGBA.
+static GdkPixbuf* to_rgba(GdkPixbuf *pixbuf) {
+    if (!gdk_pixbuf_get_has_alpha(pixbuf) || gdk_pixbuf_get_bits_per_sample(pixbuf) != 8) {
+        GdkPixbuf *rgba = gdk_pixbuf_add_alpha(pixbuf, FALSE, 0, 0, 0);
+        g_object_unref(pixbuf);
+        pixbuf = rgba;
+    }
+    return pixbuf;
+}
+
+// Reads and rasterizes the file the main thread resolved the icon to. Only
+// gdk-pixbuf runs here; GtkIconTheme is not thread-safe in GTK 3.
+static GdkPixbuf* render_icon(IconLoader *loader, const gchar *filename) {
+    GError *error = NULL;
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file_at_size(filename, loader->pixel_size, loader->pixel_size, &error);
+    if (!pixbuf) {
+        g_debug("Failed to load icon: %s", error->message);
+        g_error_free(error);
+        return NULL;
+    }
+    return to_rgba(pixbuf);
+}
+
+static gboolean deliver_icons(gpointer user_data) {
+    IconLoader *loader = user_data;
+    g_atomic_int_set(&loader->delivery_queued, FALSE);
+
+    gboolean any = FALSE;
+    IconJob *job;
+    while ((job = g_async_queue_try_pop(loader->done))) {
+        if (!g_atomic_int_get(&loader->closed)) {
+            g_hash_table_remove(loader->pending, job->icon);
+            g_hash_table_insert(loader->icons, g_object_ref(job->icon),
+                                job->pixbuf ? g_object_ref(job->pixbuf) : NULL);
+            any = TRUE;
+        }
+        icon_job_free(job);
+    }
+    if (any) {
+        loader->ready(loader->user_data);
+    }
+    icon_loader_unref(loader);
+    return G_SOURCE_REMOVE;
+}
+
+static void load_icon_func(gpointer data, gpointer user_data) {
+    IconJob *job = data;
+    IconLoader *loader = user_data;
+    if (g_atomic_int_get(&loader->closed)) {
+        icon_job_free(job);
+        return;
+    }
+
+    gchar *path = cache_file_path(loader, job->icon);
+    if (path && !loader->skip_disk_cache) {
+        job->pixbuf = read_cached_icon(path);
+    }
+    if (!job->pixbuf && job->filename) {
+        job->pixbuf = render_icon(loader, job->filename);
+        if (job->pixbuf && path) {
+            write_cached_icon(path, job->pixbuf);
+        }
+    }
+    g_free(path);
+
+    // Icons finishing close together are handed over in one main loop iteration.
+    g_async_queue_push(loader->done, job);
+    if (g_atomic_int_compare_and_exchange(&loader->delivery_queued, FALSE, TRUE)) {
+        g_idle_add(deliver_icons, icon_loader_ref(loader));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+IconLoader* icon_loader_new(gint pixel_size, gboolean skip_disk_cache, IconReadyFunc ready, gpointer user_data) {
+    IconLoader *loader = g_new0(IconLoader, 1);
+    loader->ref_count = 1;
+    loader->pixel_size = pixel_size;
+    loader->skip_disk_cache = skip_disk_cache;
+    loader->ready = ready;
+    loader->user_data = user_data;
+
+    g_object_get(gtk_settings_get_default(), "gtk-icon-theme-name", &loader->theme_name, NULL);
+    if (!loader->theme_name) loader->theme_name = g_strdup("");
+    loader->cache_dir = launcher_cache_path(ICON_CACHE_DIR);
+    g_mkdir_with_parents(loader->cache_dir, 0755);
+
+    loader->icons = g_hash_table_new_full(g_icon_hash, (GEqualFunc)g_icon_equal, g_object_unref, clear_pixbuf);
+    loader->pending = g_hash_table_new_full(g_icon_hash, (GEqualFunc)g_icon_equal, g_object_unref, NULL);
+    loader->done = g_async_queue_new();
+    loader->pool = g_thread_pool_new(load_icon_func, loader, ICON_THREADS, FALSE, NULL);
+    return loader;
+}
+
+GdkPixbuf* icon_loader_lookup(IconLoader *loader, GIcon *icon) {
+    gpointer pixbuf;
+    if (g_hash_table_lookup_extended(loader->icons, icon, NULL, &pixbuf)) {
+        return pixbuf;
+    }
+    if (g_hash_table_contains(loader->pending, icon)) {
+        return NULL;
+    }
+
+    // Resolving the icon takes the theme, which only the main thread may use;
+    // the pool gets just the file to read.
+    GtkIconInfo *info = gtk_icon_theme_lookup_by_gicon(gtk_icon_theme_get_default(), icon, loader->pixel_size,
+                                                       GTK_ICON_LOOKUP_FORCE_SIZE);
+    const gchar *filename = info ? gtk_icon_info_get_filename(info) : NULL;
+    if (info && !filename) {
+        // Built into GTK, with no file to hand over: load it right here.
+        pixbuf = gtk_icon_info_load_icon(info, NULL);
+        if (pixbuf) pixbuf = to_rgba(pixbuf);
+        g_hash_table_insert(loader->icons, g_object_ref(icon), pixbuf);
+        g_object_unref(info);
+        return pixbuf;
+    }
+
+    g_hash_table_add(loader->pending, g_object_ref(icon));
+    IconJob *job = g_new0(IconJob, 1);
+    job->icon = g_object_ref(icon);
+    job->filename = g_strdup(filename);
+    if (info) g_object_unref(info);
+    g_thread_pool_push(loader->pool, job, NULL);
+    return NULL;
+}
+
+void icon_loader_free(IconLoader *loader) {
+    if (!loader) return;
+    g_atomic_int_set(&loader->closed, TRUE);
+    // Queued jobs see the closed flag and return at once; running ones finish
+    // and deliver to nobody.
+    g_thread_pool_free(loader->pool, FALSE, TRUE);
+    g_hash_table_destroy(loader->icons);
+    g_hash_table_destroy(loader->pending);
+    icon_loader_unref(loader);
+}
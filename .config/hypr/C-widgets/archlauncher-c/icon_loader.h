@@ -0,0 +1,27 @@
+#ifndef ICON_LOADER_H
+#define ICON_LOADER_H
+
+#include <gtk/gtk.h>
+
+// Name of the rasterized icon cache directory inside ~/.cache/cachy/
+#define ICON_CACHE_DIR "icons"
+
+typedef struct _IconLoader IconLoader;
+
+// Called on the main loop whenever one or more requested icons became ready.
+typedef void (*IconReadyFunc)(gpointer user_data);
+
+// Resolves icons to files on the main thread and rasterizes them at pixel_size
+// on a small thread pool, backed by an on-disk cache keyed by icon, icon theme
+// and size. With skip_disk_cache the cache is rewritten but never read.
+IconLoader* icon_loader_new(gint pixel_size, gboolean skip_disk_cache, IconReadyFunc ready, gpointer user_data);
+
+// Returns the rasterized icon if it is ready (transfer none). Otherwise queues
+// it, if not queued yet, and returns NULL; ready is called once it loaded.
+// Icons that fail to load keep returning NULL without being retried.
+GdkPixbuf* icon_loader_lookup(IconLoader *loader, GIcon *icon);
+
+// Drops queued work, waits for running jobs and frees the loader.
+void icon_loader_free(IconLoader *loader);
+
+#endif // ICON_LOADER_H
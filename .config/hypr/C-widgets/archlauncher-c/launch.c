@@ -0,0 +1,170 @@
+#define _GNU_SOURCE // POSIX_SPAWN_SETSID, posix_spawn_file_actions_addchdir_np()
+#include "launch.h"
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+// Field Codes
+// -----------------------------------------------------------------------------
+
+// Appends one Exec argument to argv with its field codes expanded. An argument
+// that was nothing but dropped codes (e.g. a lone %U) disappears entirely.
+static void expand_argument(GPtrArray *argv, const gchar *arg, const gchar *name, const gchar *icon) {
+    if (strcmp(arg, "%i") == 0) {
+        if (icon) {
+            g_ptr_array_add(argv, g_strdup("--icon"));
+            g_ptr_array_add(argv, g_strdup(icon));
+        }
+        return;
+    }
+
+    GString *out = g_string_sized_new(strlen(arg));
+    gboolean had_code = FALSE;
+    for (const gchar *p = arg; *p; p++) {
+        if (*p != '%') {
+            g_string_append_c(out, *p);
+            continue;
+        }
+        p++;
+        if (*p == '\0') break;
+        had_code = TRUE;
+        if (*p == '%') {
+            g_string_append_c(out, '%');
+        } else if (*p == 'c') {
+            g_string_append(out, name);
+        }
+        // No files or URLs are passed, %k has no file to name and the rest
+        // are deprecated, so every other code expands to nothing.
+    }
+
+    if (out->len > 0 || !had_code) {
+        g_ptr_array_add(argv, g_string_free(out, FALSE));
+    } else {
+        g_string_free(out, TRUE);
+    }
+}
+
+gchar** launch_build_argv(const gchar *exec, const gchar *name, GIcon *icon, GError **error) {
+    gchar **words = NULL;
+    if (!g_shell_parse_argv(exec, NULL, &words, error)) {
+        return NULL;
+    }
+
+    gchar *icon_str = icon ? g_icon_to_string(icon) : NULL;
+    GPtrArray *argv = g_ptr_array_new();
+    for (gint i = 0; words[i] != NULL; i++) {
+        expand_argument(argv, words[i], name, icon_str);
+    }
+    g_free(icon_str);
+    g_strfreev(words);
+
+    if (argv->len == 0) {
+        g_ptr_array_free(argv, TRUE);
+        g_set_error(error, G_SHELL_ERROR, G_SHELL_ERROR_EMPTY_STRING, "Exec line has no program: %s", exec);
+        return NULL;
+    }
+    g_ptr_array_add(argv, NULL);
+    return (gchar **)g_ptr_array_free(argv, FALSE);
+}
+
+gchar* launch_resolve_program(const gchar *exec) {
+    gchar **words = NULL;
+    if (!g_shell_parse_argv(exec, NULL, &words, NULL)) {
+        return NULL;
+    }
+    gchar *path = NULL;
+    if (g_path_is_absolute(words[0])) {
+        path = g_strdup(words[0]);
+    } else if (!strchr(words[0], '/')) {
+        path = g_find_program_in_path(words[0]);
+    }
+    g_strfreev(words);
+    return path;
+}
+
+// -----------------------------------------------------------------------------
+// Spawning
+// -----------------------------------------------------------------------------
+
+// posix_spawn() uses vfork semantics, so no page tables of the launcher are
+// copied however large its catalogs are. The child gets a session of its own
+// (nothing the launcher's terminal or exit does reaches it), default signal
+// dispositions, an empty signal mask and the home directory to start in.
+// With path NULL, argv[0] is searched in $PATH.
+static gint spawn_detached(const gchar *path, gchar **argv, GPid *out_pid) {
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    sigset_t defaults;
+    sigfillset(&defaults);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addchdir_np(&actions, g_get_home_dir());
+
+    pid_t pid;
+    gint err = path ? posix_spawn(&pid, path, &actions, &attr, argv, environ)
+                    : posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+    if (err == 0) {
+        *out_pid = pid;
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    return err;
+}
+
+gboolean launch_app(AppInfo *app, LaunchKind kind, GPid *out_pid, GError **error) {
+    gchar **argv = NULL;
+    switch (kind) {
+        case LAUNCH_DESKTOP_ENTRY:
+            argv = launch_build_argv(app->exec, app->name, app->icon, error);
+            break;
+        case LAUNCH_PROGRAM:
+            // A file name, not a command line to parse.
+            argv = g_new0(gchar *, 2);
+            argv[0] = g_strdup(app->exec);
+            break;
+        case LAUNCH_COMMAND_LINE:
+            // Quoted like a shell would, but without any field codes.
+            g_shell_parse_argv(app->exec, NULL, &argv, error);
+            break;
+        case LAUNCH_FILE:
+            // Opened with whatever the desktop associates with its type.
+            argv = g_new0(gchar *, 3);
+            argv[0] = g_strdup("xdg-open");
+            argv[1] = g_build_filename(g_get_home_dir(), app->exec, NULL);
+            break;
+        case LAUNCH_WINDOW:
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is a window, not a program", app->exec);
+            return FALSE;
+        case LAUNCH_COPY:
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s is text to copy, not a program", app->exec);
+            return FALSE;
+    }
+    if (!argv) return FALSE;
+
+    // The resolved path only stands in for a program given by name; an Exec
+    // line naming a path of its own runs exactly that.
+    const gchar *path = app->path && !strchr(argv[0], '/') ? app->path : NULL;
+    gint err = spawn_detached(path, argv, out_pid);
+    if (path && (err == ENOENT || err == EACCES)) {
+        // The program moved since the cache was written; fall back to a search.
+        g_debug("Cached path %s is stale, searching $PATH for %s", path, argv[0]);
+        err = spawn_detached(NULL, argv, out_pid);
+    }
+
+    if (err != 0) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(err),
+                    "Failed to execute %s: %s", argv[0], g_strerror(err));
+    }
+    g_strfreev(argv);
+    return err == 0;
+}
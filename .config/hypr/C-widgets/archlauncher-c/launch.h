@@ -0,0 +1,34 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <glib.h>
+#include "app_info.h"
+
+// What the exec string of an entry holds, which decides how it is started
+typedef enum {
+    LAUNCH_DESKTOP_ENTRY, // A desktop entry Exec line with field codes
+    LAUNCH_PROGRAM,       // The bare name of an executable
+    LAUNCH_COMMAND_LINE,  // A command line with arguments, as typed by the user
+    LAUNCH_WINDOW,        // The address of a Hyprland window to focus, not a program
+    LAUNCH_FILE,          // A path relative to the home directory, opened with xdg-open
+    LAUNCH_COPY           // Text to put on the clipboard, not a program
+} LaunchKind;
+
+// Splits a desktop entry Exec line into argv and expands its field codes as
+// the Desktop Entry Specification describes for a launch without files: the
+// file and URL codes (%f %F %u %U) and the deprecated ones are dropped, %c
+// becomes the name, %i becomes "--icon <icon>" and %% a literal %.
+// Returns NULL and sets error if the line cannot be parsed.
+gchar** launch_build_argv(const gchar *exec, const gchar *name, GIcon *icon, GError **error);
+
+// Returns the absolute path of the program an Exec line runs, looked up in
+// $PATH now so that launching needs no search. NULL if it cannot be found.
+gchar* launch_resolve_program(const gchar *exec);
+
+// Starts app in a session of its own, detached from the launcher, using the
+// resolved app->path when it has one. kind tells how to read app->exec. On
+// success *out_pid is the child, which the caller reaps (or leaves to init by
+// exiting).
+gboolean launch_app(AppInfo *app, LaunchKind kind, GPid *out_pid, GError **error);
+
+#endif // LAUNCH_H
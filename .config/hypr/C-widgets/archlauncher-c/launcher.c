@@ -3,9 +3,21 @@
 #include <gio/gio.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <glib-unix.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fontconfig/fontconfig.h>
+#include "app_info.h"
+#include "app_index.h"
+#include "run_cache.h"
+#include "catalog.h"
+#include "result_view.h"
+#include "daemon_ipc.h"
+#include "icon_loader.h"
+#include "launch.h"
+#include "hypr_ipc.h"
+#include "file_index.h"
+#include "prefetch.h"
 
 // -----------------------------------------------------------------------------
 // Constants and Type Definitions
@@ -14,32 +26,32 @@
 #define WINDOW_WIDTH 350
 #define WINDOW_HEIGHT 400
 #define TOP_MARGIN 6
-#define CACHE_DIR_NAME "cachy"
-#define RUN_CACHE_FILE "run_cache.txt"
-
-// A struct to hold our simplified application info
-typedef struct {
-    char *name;
-    char *exec;
-    GIcon *icon;
-} AppInfo;
-
-// The mode of operation (application launcher or command runner)
-typedef enum {
-    MODE_DRUN,
-    MODE_RUN
-} LauncherMode;
+#define PREFETCH_TOP_ENTRIES 3          // Most launched entries prefetched on every show
+#define PREFETCH_SELECTION_DELAY_MS 150 // How long the selection rests before its program is prefetched
+
+typedef struct _LauncherData LauncherData;
 
 // A struct to hold all the state and widgets for our application
-typedef struct {
+struct _LauncherData {
     GtkWindow *window;
     GtkEntry *entry;
-    GtkListBox *list_box;
-    GSList *apps;
+    ResultView *result_view;
+    IconLoader *icons;        // NULL with --no-icons
     LauncherMode mode;
     gboolean no_icons;
     gboolean rebuild_cache; // <<< FIX: Flag to force cache rebuild
-} LauncherData;
+    gboolean daemon;        // Stay resident: hide instead of quitting
+    gint socket_fd;         // The daemon's listening socket, -1 otherwise
+    guint reload_source;    // Pending check for outdated catalogs after hiding
+    gint64 launch_time;     // Monotonic time of the last launch, for timing the exit
+    gchar *clipboard_text;  // What the launcher put on the clipboard, while it owns it
+    Prefetcher *prefetcher; // Warms the page cache for likely launches while shown
+    guint prefetch_source;  // Pending prefetch of the selected entry
+
+    Catalog *catalogs[N_MODES]; // Indexed by LauncherMode, loaded on first use
+    Catalog *reloading[N_MODES]; // Replacements still loading, swapped in once settled
+    GArray *visible_ids;      // Positions of the matches of the current query
+};
 
 // -----------------------------------------------------------------------------
 // Forward Declarations (Prototypes)
@@ -47,239 +59,255 @@ typedef struct {
 
 void launch_selected_app(LauncherData *data);
 void navigate_list(LauncherData *data, gint direction);
+void page_list(LauncherData *data, gint direction);
 gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data);
 void on_search_changed(GtkEntry *entry, gpointer user_data);
-void on_launch_app(GtkListBox *box, GtkListBoxRow *row, gpointer user_data);
+void on_launch_app(gpointer user_data);
 void on_entry_activate(GtkEntry *entry, gpointer user_data);
-GSList* get_applications(gboolean no_icons);
-// <<< FIX: Signature changed to accept rebuild_cache flag
-GSList* get_run_executables(gboolean no_icons, gboolean rebuild_cache);
 void create_launcher_window(LauncherData *data);
 gboolean populate_list(gpointer user_data);
+void show_launcher(LauncherData *data, LauncherMode mode);
+void hide_launcher(LauncherData *data);
 void load_css();
 
 // -----------------------------------------------------------------------------
 // Helper and Utility Functions
 // -----------------------------------------------------------------------------
 
-// Frees the memory associated with an AppInfo struct
-void free_app_info(gpointer data) {
-    AppInfo *app = (AppInfo *)data;
-    g_free(app->name);
-    g_free(app->exec);
-    if (app->icon) {
-        g_object_unref(app->icon);
-    }
-    g_free(app);
+// Loads custom CSS for styling the application
+void load_css() {
+    GtkCssProvider *provider = gtk_css_provider_new();
+    GdkDisplay *display = gdk_display_get_default();
+    GdkScreen *screen = gdk_display_get_default_screen(display);
+    gtk_css_provider_load_from_path(provider, "launcher.css", NULL);
+    gtk_style_context_add_provider_for_screen(screen, GTK_STYLE_PROVIDER(provider), GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    g_object_unref(provider);
 }
 
-// Comparison function for sorting AppInfo structs alphabetically by name
-gint compare_apps(gconstpointer a, gconstpointer b) {
-    AppInfo *app_a = (AppInfo *)a;
-    AppInfo *app_b = (AppInfo *)b;
-    return g_strcmp0(app_a->name, app_b->name);
+static Catalog* current_catalog(LauncherData *data) {
+    return data->catalogs[data->mode];
 }
 
-// Scans for and returns a list of all .desktop applications
-GSList* get_applications(gboolean no_icons) {
-    GSList *apps = NULL;
-    GList *app_infos = g_app_info_get_all();
+// Closes the launcher: the daemon only hides the window, a one-shot launcher exits.
+static void dismiss_launcher(LauncherData *data) {
+    if (data->daemon) {
+        hide_launcher(data);
+    } else {
+        gtk_main_quit();
+    }
+}
 
-    for (GList *l = app_infos; l != NULL; l = l->next) {
-        GAppInfo *app_info = G_APP_INFO(l->data);
-        if (g_app_info_should_show(app_info)) {
-            const gchar *name = g_app_info_get_display_name(app_info);
-            const gchar *exec = g_app_info_get_commandline(app_info);
-            if (!name || !exec) {
-                continue;
-            }
+// Reaps an application the daemon started once it exits.
+static void on_child_exit(GPid pid, gint status, gpointer user_data) {
+    g_spawn_close_pid(pid);
+}
 
-            AppInfo *app = g_new(AppInfo, 1);
-            app->name = g_strdup(name);
-            app->exec = g_strdup(exec);
-
-            if (no_icons) {
-                app->icon = NULL;
-            } else {
-                app->icon = g_app_info_get_icon(app_info);
-                if (app->icon) {
-                    g_object_ref(app->icon);
-                }
-            }
-            apps = g_slist_prepend(apps, app);
-        }
-    }
-    g_list_free_full(app_infos, g_object_unref);
-    apps = g_slist_sort(apps, compare_apps);
-    return apps;
+// Unmaps the window and pushes the request out right away, so the window is
+// gone by the next compositor frame however long launching takes.
+static gint64 unmap_for_launch(LauncherData *data) {
+    gtk_widget_hide(GTK_WIDGET(data->window));
+    gdk_display_flush(gdk_display_get_default());
+    return g_get_monotonic_time();
 }
 
-// <<< FIX: THIS ENTIRE FUNCTION IS REWORKED FOR CACHING >>>
-// Scans for executables in $PATH, using a cache for speed.
-GSList* get_run_executables(gboolean no_icons, gboolean rebuild_cache) {
-    GSList *apps = NULL;
+// Starts app and closes the launcher. Returns TRUE if it started. Run with
+// G_MESSAGES_DEBUG=all to see how long after Enter the window went away, the
+// application started and the launcher exited.
+static gboolean start_and_dismiss(LauncherData *data, AppInfo *app, LaunchKind kind, gint64 start) {
+    gint64 unmapped = unmap_for_launch(data);
+    GPid pid;
+    GError *error = NULL;
+    gboolean started = launch_app(app, kind, &pid, &error);
+    if (started) {
+        g_debug("Launch timing: unmapped after %.2f ms, spawned %s after %.2f ms",
+                (unmapped - start) / 1000.0, app->path ? app->path : app->exec,
+                (g_get_monotonic_time() - start) / 1000.0);
+        // A one-shot launcher exits right away and leaves the child to init.
+        if (data->daemon) {
+            g_child_watch_add(pid, on_child_exit, NULL);
+        }
+    } else {
+        g_warning("Failed to launch application: %s", error->message);
+        g_error_free(error);
+    }
 
-    // 1. Determine the cache file path (~/.cache/cachy/run_cache.txt)
-    const gchar *cache_dir = g_get_user_cache_dir();
-    gchar *cache_path = g_build_filename(cache_dir, CACHE_DIR_NAME, RUN_CACHE_FILE, NULL);
+    data->launch_time = start;
+    dismiss_launcher(data);
+    return started;
+}
 
-    // 2. Decide if we need to rebuild the cache
-    gboolean do_rebuild = rebuild_cache || !g_file_test(cache_path, G_FILE_TEST_EXISTS);
+// Focuses the window behind app and closes the launcher. The focus request
+// goes out before the launcher unmaps, so the compositor never has to pick a
+// window to fall back to in between.
+static gboolean focus_and_dismiss(LauncherData *data, AppInfo *app, gint64 start) {
+    GError *error = NULL;
+    gboolean focused = hypr_ipc_focus_window(app->exec, &error);
+    gint64 unmapped = unmap_for_launch(data);
+    if (focused) {
+        g_debug("Switch timing: focused %s, unmapped after %.2f ms", app->exec, (unmapped - start) / 1000.0);
+    } else {
+        g_warning("Failed to focus window: %s", error->message);
+        g_error_free(error);
+    }
 
-    if (do_rebuild) {
-        // --- SLOW PATH: Scan filesystem and write to cache ---
-        g_debug("Rebuilding RUN cache at: %s", cache_path);
-        const gchar *path_env = g_getenv("PATH");
-        if (!path_env) {
-             g_free(cache_path);
-             return NULL;
-        }
+    data->launch_time = start;
+    dismiss_launcher(data);
+    return focused;
+}
 
-        gchar **paths = g_strsplit(path_env, ":", 0);
-        GHashTable *seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-        GString *cache_content = g_string_new("");
-
-        for (int i = 0; paths[i] != NULL; i++) {
-            GDir *dir = g_dir_open(paths[i], 0, NULL);
-            if (!dir) continue;
-
-            const gchar *filename;
-            while ((filename = g_dir_read_name(dir))) {
-                if (filename[0] == '.' || g_hash_table_contains(seen, filename)) {
-                    continue;
-                }
-                gchar *full_path = g_build_filename(paths[i], filename, NULL);
-                if (g_file_test(full_path, G_FILE_TEST_IS_EXECUTABLE) && !g_file_test(full_path, G_FILE_TEST_IS_DIR)) {
-                    g_hash_table_add(seen, g_strdup(filename));
-                    // Also add to our cache string for saving later
-                    g_string_append_printf(cache_content, "%s\n", filename);
-                }
-                g_free(full_path);
-            }
-            g_dir_close(dir);
-        }
+// Hands the copied text to whoever pastes it.
+static void on_clipboard_get(GtkClipboard *clipboard, GtkSelectionData *selection, guint info, gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    gtk_selection_data_set_text(selection, data->clipboard_text, -1);
+}
 
-        // Save the collected names to the cache file
-        gchar *cache_dir_path = g_path_get_dirname(cache_path);
-        g_mkdir_with_parents(cache_dir_path, 0755);
-        g_file_set_contents(cache_path, cache_content->str, -1, NULL);
-        g_free(cache_dir_path);
-        g_string_free(cache_content, TRUE);
-
-        // Now, create the AppInfo list from the 'seen' hash table for the current session
-        GList* keys = g_hash_table_get_keys(seen);
-        for(GList* l = keys; l != NULL; l = l->next) {
-            const gchar* filename = l->data;
-            AppInfo *app = g_new(AppInfo, 1);
-            app->name = g_strdup(filename);
-            app->exec = g_strdup(filename);
-            app->icon = NULL; // Icon is set later
-            apps = g_slist_prepend(apps, app);
-        }
-        g_list_free(keys);
-        g_hash_table_destroy(seen);
-        g_strfreev(paths);
+// Another client took the clipboard over. A one-shot launcher only stayed
+// around to serve it, the way wl-copy does, so it can exit now.
+static void on_clipboard_clear(GtkClipboard *clipboard, gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    g_clear_pointer(&data->clipboard_text, g_free);
+    if (!data->daemon) {
+        gtk_main_quit();
+    }
+}
 
+// Puts app->exec on the clipboard and closes the launcher, all in process.
+// The selection is claimed while the window still has keyboard focus, as
+// Wayland compositors only accept it from the focused client.
+static gboolean copy_and_dismiss(LauncherData *data, AppInfo *app, gint64 start) {
+    GtkTargetList *list = gtk_target_list_new(NULL, 0);
+    gtk_target_list_add_text_targets(list, 0);
+    gint n_targets;
+    GtkTargetEntry *targets = gtk_target_table_new_from_list(list, &n_targets);
+    // Clears whatever the launcher copied before, through on_clipboard_clear().
+    gboolean copied = gtk_clipboard_set_with_data(gtk_clipboard_get(GDK_SELECTION_CLIPBOARD), targets, n_targets,
+                                                  on_clipboard_get, on_clipboard_clear, data);
+    gtk_target_table_free(targets, n_targets);
+    gtk_target_list_unref(list);
+
+    gint64 unmapped = unmap_for_launch(data);
+    if (copied) {
+        data->clipboard_text = g_strdup(app->exec);
+        g_debug("Copy timing: copied %s, unmapped after %.2f ms", app->exec, (unmapped - start) / 1000.0);
     } else {
-        // --- FAST PATH: Read from cache file ---
-        g_debug("Reading RUN cache from: %s", cache_path);
-        gchar *contents;
-        gsize length;
-        if (g_file_get_contents(cache_path, &contents, &length, NULL)) {
-            gchar **lines = g_strsplit(contents, "\n", -1);
-            for (int i = 0; lines[i] != NULL; i++) {
-                if (lines[i][0] == '\0') continue; // Skip empty lines
-                AppInfo *app = g_new(AppInfo, 1);
-                app->name = g_strdup(lines[i]);
-                app->exec = g_strdup(lines[i]);
-                app->icon = NULL; // Icon is set later
-                apps = g_slist_prepend(apps, app);
-            }
-            g_strfreev(lines);
-            g_free(contents);
-        }
+        g_warning("Failed to take over the clipboard");
     }
-    g_free(cache_path);
 
-    // 3. Sort and apply icons (common to both paths)
-    apps = g_slist_sort(apps, compare_apps);
-    if (!no_icons) {
-        GIcon *generic_icon = g_themed_icon_new("utilities-terminal");
-        for (GSList *l = apps; l != NULL; l = l->next) {
-            AppInfo *app = (AppInfo *)l->data;
-            app->icon = g_object_ref(generic_icon);
-        }
-        g_object_unref(generic_icon);
+    data->launch_time = start;
+    // A one-shot launcher keeps running, hidden, until the clipboard changes hands.
+    if (data->daemon || !copied) {
+        dismiss_launcher(data);
     }
-    return apps;
+    return copied;
 }
 
-// Loads custom CSS for styling the application
-void load_css() {
-    GtkCssProvider *provider = gtk_css_provider_new();
-    GdkDisplay *display = gdk_display_get_default();
-    GdkScreen *screen = gdk_display_get_default_screen(display);
-    gtk_css_provider_load_from_path(provider, "launcher.css", NULL);
-    gtk_style_context_add_provider_for_screen(screen, GTK_STYLE_PROVIDER(provider), GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-    g_object_unref(provider);
+// Runs the typed text as a command line and remembers it in the history.
+static void run_typed_command(LauncherData *data) {
+    gint64 start = g_get_monotonic_time();
+    gchar *line = g_strstrip(g_strdup(gtk_entry_get_text(data->entry)));
+    if (line[0] != '\0') {
+        AppInfo *typed = app_info_new(line, line, NULL);
+        if (start_and_dismiss(data, typed, LAUNCH_COMMAND_LINE, start) && current_catalog(data)) {
+            catalog_record_command(current_catalog(data), line);
+        }
+        free_app_info(typed);
+    }
+    g_free(line);
 }
 
-// Launches the currently selected application in the list box
+// Launches the currently selected application in the result list. In run
+// mode with nothing selected, the typed text runs as a command line instead.
 void launch_selected_app(LauncherData *data) {
-    GtkListBoxRow *selected_row = gtk_list_box_get_selected_row(data->list_box);
-    if (!selected_row) return;
+    gint64 start = g_get_monotonic_time();
+    AppInfo *app = result_view_get_selected(data->result_view);
+    if (!app) {
+        if (data->mode == MODE_RUN) run_typed_command(data);
+        return;
+    }
+    guint32 id = g_array_index(data->visible_ids, guint32, result_view_get_selected_index(data->result_view));
+    CatalogSegment *segment = current_catalog(data) ? catalog_get_segment(current_catalog(data), id) : NULL;
+    LaunchKind kind = segment ? segment->provider->launch_kind
+                              : data->mode == MODE_DRUN ? LAUNCH_DESKTOP_ENTRY : LAUNCH_PROGRAM;
+
+    if (kind == LAUNCH_WINDOW) {
+        focus_and_dismiss(data, app, start);
+        return;
+    }
 
-    AppInfo *app = g_object_get_data(G_OBJECT(selected_row), "app-info");
-    if (!app) return;
+    // The daemon keeps the catalog (and so app) alive past the dismissal.
+    Catalog *catalog = current_catalog(data);
+    gboolean done = kind == LAUNCH_COPY ? copy_and_dismiss(data, app, start)
+                                        : start_and_dismiss(data, app, kind, start);
+    if (done && catalog) {
+        catalog_record_launch(catalog, id);
+    }
+}
 
-    gchar **parts = g_strsplit(app->exec, "%", 2);
-    gchar *cmd = g_strstrip(parts[0]);
-    gchar **argv = NULL;
-    GError *error = NULL;
+// Replaces the typed text with the most launched name it is a prefix of.
+static void complete_entry(LauncherData *data) {
+    Catalog *catalog = current_catalog(data);
+    if (!catalog) return;
+    gchar *completion = catalog_complete(catalog, gtk_entry_get_text(data->entry));
+    if (completion) {
+        gtk_entry_set_text(data->entry, completion);
+        gtk_editable_set_position(GTK_EDITABLE(data->entry), -1);
+        g_free(completion);
+    }
+}
 
-    if (g_shell_parse_argv(cmd, NULL, &argv, &error)) {
-        g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, NULL, &error);
+// -----------------------------------------------------------------------------
+// Prefetching
+// -----------------------------------------------------------------------------
+
+// Prefetches the programs of the entries launched most, once per show.
+static void prefetch_most_frecent(LauncherData *data) {
+    Catalog *catalog = current_catalog(data);
+    if (!catalog || !gtk_widget_get_visible(GTK_WIDGET(data->window))) return;
+    GArray *ids = catalog_get_most_frecent(catalog, PREFETCH_TOP_ENTRIES);
+    for (guint i = 0; i < ids->len; i++) {
+        AppInfo *app = g_ptr_array_index(catalog->app_array, g_array_index(ids, guint32, i));
+        if (app->path) prefetcher_request(data->prefetcher, app->path);
     }
+    g_array_unref(ids);
+}
 
-    if (error) {
-        g_warning("Failed to launch application: %s", error->message);
-        g_error_free(error);
+static gboolean prefetch_selected(gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    data->prefetch_source = 0;
+    AppInfo *app = result_view_get_selected(data->result_view);
+    if (app && app->path) {
+        prefetcher_request(data->prefetcher, app->path);
     }
+    return G_SOURCE_REMOVE;
+}
 
-    g_strfreev(argv);
-    g_strfreev(parts);
-    gtk_main_quit();
+// Prefetches the selected entry's program once the selection rested for a
+// moment, so scrolling through the list doesn't read every program passed.
+static void schedule_prefetch_selected(LauncherData *data) {
+    if (data->prefetch_source) g_source_remove(data->prefetch_source);
+    data->prefetch_source = g_timeout_add(PREFETCH_SELECTION_DELAY_MS, prefetch_selected, data);
 }
 
-// Navigates the listbox up or down and ensures the selected item is visible
-void navigate_list(LauncherData *data, gint direction) {
-    GtkListBoxRow *selected_row = gtk_list_box_get_selected_row(data->list_box);
-    if (!selected_row) return;
-
-    GList *all_rows = gtk_container_get_children(GTK_CONTAINER(data->list_box));
-    GSList *visible_rows = NULL;
-    for (GList *l = all_rows; l != NULL; l = l->next) {
-        if (gtk_widget_is_visible(l->data)) {
-            visible_rows = g_slist_prepend(visible_rows, l->data);
-        }
+static void stop_prefetching(LauncherData *data) {
+    if (data->prefetch_source) {
+        g_source_remove(data->prefetch_source);
+        data->prefetch_source = 0;
     }
-    g_list_free(all_rows);
-    visible_rows = g_slist_reverse(visible_rows);
-    if (!visible_rows) return;
+    prefetcher_cancel(data->prefetcher);
+}
 
-    gint index = g_slist_index(visible_rows, selected_row);
-    if (index != -1) {
-        gint len = g_slist_length(visible_rows);
-        gint new_index = (index + direction + len) % len;
-        GtkListBoxRow *new_row = g_slist_nth_data(visible_rows, new_index);
+// Moves the selection up or down, wrapping around, and keeps it in view
+void navigate_list(LauncherData *data, gint direction) {
+    result_view_move_selection(data->result_view, direction);
+    schedule_prefetch_selected(data);
+}
 
-        if (new_row) {
-            gtk_list_box_select_row(data->list_box, new_row);
-            gtk_widget_grab_focus(GTK_WIDGET(new_row));
-            gtk_widget_grab_focus(GTK_WIDGET(data->entry));
-        }
-    }
-    g_slist_free(visible_rows);
+// Moves the selection a screenful up or down, stopping at either end
+void page_list(LauncherData *data, gint direction) {
+    gint page = result_view_get_page_size(data->result_view);
+    gint selected = result_view_get_selected_index(data->result_view);
+    result_view_select(data->result_view, selected + direction * page);
+    schedule_prefetch_selected(data);
 }
 
 // -----------------------------------------------------------------------------
@@ -290,7 +318,7 @@ gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
     LauncherData *data = (LauncherData *)user_data;
     switch (event->keyval) {
         case GDK_KEY_Escape:
-            gtk_main_quit();
+            dismiss_launcher(data);
             return TRUE;
         case GDK_KEY_Down:
             navigate_list(data, 1);
@@ -298,105 +326,277 @@ gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer user_data)
         case GDK_KEY_Up:
             navigate_list(data, -1);
             return TRUE;
+        case GDK_KEY_Page_Down:
+            page_list(data, 1);
+            return TRUE;
+        case GDK_KEY_Page_Up:
+            page_list(data, -1);
+            return TRUE;
+        case GDK_KEY_Home:
+            result_view_select(data->result_view, 0);
+            schedule_prefetch_selected(data);
+            return TRUE;
+        case GDK_KEY_End:
+            result_view_select(data->result_view, G_MAXINT);
+            schedule_prefetch_selected(data);
+            return TRUE;
+        case GDK_KEY_Tab:
+            complete_entry(data);
+            return TRUE;
+        case GDK_KEY_Return:
+        case GDK_KEY_KP_Enter:
+            // Shift-Enter runs the text as typed, whatever is selected.
+            if (data->mode == MODE_RUN && (event->state & GDK_SHIFT_MASK)) {
+                run_typed_command(data);
+                return TRUE;
+            }
+            return FALSE;
+        case GDK_KEY_n:
+        case GDK_KEY_p:
+            if (event->state & GDK_CONTROL_MASK) {
+                navigate_list(data, event->keyval == GDK_KEY_n ? 1 : -1);
+                return TRUE;
+            }
+            return FALSE;
         default:
             return FALSE;
     }
 }
 
-void on_search_changed(GtkEntry *entry, gpointer user_data) {
-    LauncherData *data = (LauncherData *)user_data;
-    const gchar *search_text = gtk_entry_get_text(entry);
-    gchar *search_lower = g_utf8_strdown(search_text, -1);
-
-    GList *children = gtk_container_get_children(GTK_CONTAINER(data->list_box));
-    gboolean has_visible_rows = FALSE;
-
-    for (GList *l = children; l != NULL; l = l->next) {
-        GtkWidget *row = l->data;
-        AppInfo *app = g_object_get_data(G_OBJECT(row), "app-info");
-        if (!app) continue;
-
-        gchar *name_lower = g_utf8_strdown(app->name, -1);
-        if (g_strrstr(name_lower, search_lower)) {
-            gtk_widget_show(row);
-            has_visible_rows = TRUE;
-        } else {
-            gtk_widget_hide(row);
-        }
-        g_free(name_lower);
-    }
-    g_list_free(children);
-    g_free(search_lower);
-
-    if (has_visible_rows) {
-        GtkListBoxRow *selected_row = gtk_list_box_get_selected_row(data->list_box);
-        if (!selected_row || !gtk_widget_is_visible(GTK_WIDGET(selected_row))) {
-            GList *all_rows = gtk_container_get_children(GTK_CONTAINER(data->list_box));
-            for (GList *l = all_rows; l != NULL; l = l->next) {
-                if (gtk_widget_is_visible(l->data)) {
-                    gtk_list_box_select_row(data->list_box, GTK_LIST_BOX_ROW(l->data));
-                    break;
-                }
-            }
-            g_list_free(all_rows);
+static void adopt_reloaded(LauncherData *data, LauncherMode mode);
+
+// Applies the newest merged result of the providers. Only the array of visible
+// positions changes; the result view rebinds the handful of rows on screen.
+static void on_filter_result(FilterResult *result, gpointer user_data) {
+    Catalog *catalog = user_data;
+    LauncherData *data = (LauncherData *)catalog->owner;
+    // The daemon may have switched modes since the query was submitted, or
+    // this is a replacement reloading in the background.
+    if (catalog != current_catalog(data)) {
+        filter_result_free(result);
+        if (catalog == data->reloading[catalog->mode]) {
+            adopt_reloaded(data, catalog->mode);
         }
+        return;
+    }
+    g_array_set_size(data->visible_ids, result->matches->len);
+    guint32 *ids = (guint32 *)data->visible_ids->data;
+    for (guint i = 0; i < result->matches->len; i++) {
+        ids[i] = g_array_index(result->matches, FilterMatch, i).id;
+    }
+    result_view_set_items(data->result_view, ids, data->visible_ids->len, &result->query, result->generation);
+    filter_result_free(result);
+    schedule_prefetch_selected(data);
+}
+
+static void on_catalog_progress(Catalog *catalog) {
+    LauncherData *data = (LauncherData *)catalog->owner;
+    if (catalog == data->reloading[catalog->mode]) {
+        adopt_reloaded(data, catalog->mode);
+        return;
+    }
+    if (catalog == current_catalog(data) && catalog->n_pending == 0 && catalog->app_array->len == 0) {
+        g_printerr("No items found for the selected mode.\n");
+    }
+    if (catalog == current_catalog(data)) {
+        prefetch_most_frecent(data);
     }
 }
 
-void on_launch_app(GtkListBox *box, GtkListBoxRow *row, gpointer user_data) {
+// Filtering runs on the provider workers; the merged result comes back through on_filter_result().
+void on_search_changed(GtkEntry *entry, gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    Catalog *catalog = current_catalog(data);
+    if (!catalog) return;
+    catalog_submit(catalog, gtk_entry_get_text(entry));
+}
+
+void on_launch_app(gpointer user_data) {
     LauncherData *data = (LauncherData *)user_data;
     launch_selected_app(data);
 }
 
+static void on_icons_ready(gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    result_view_icons_ready(data->result_view);
+}
+
 void on_entry_activate(GtkEntry *entry, gpointer user_data) {
     LauncherData *data = (LauncherData *)user_data;
     launch_selected_app(data);
 }
 
+// Points the result view at the current mode's entries. The empty query order
+// shows at once if it is known; anything else streams in from the providers.
+static void show_catalog(LauncherData *data) {
+    Catalog *catalog = current_catalog(data);
+    if (!catalog) return;
+    result_view_set_apps(data->result_view, catalog->app_array);
+    g_array_set_size(data->visible_ids, 0);
+
+    const gchar *text = gtk_entry_get_text(data->entry);
+    if (g_strcmp0(catalog->query, text) != 0) {
+        catalog_submit(catalog, text);
+    }
+    if (text[0] == '\0' && catalog->default_ids) {
+        g_array_append_vals(data->visible_ids, catalog->default_ids->data, catalog->default_ids->len);
+        result_view_set_items(data->result_view, (const guint32 *)data->visible_ids->data,
+                              data->visible_ids->len, NULL, catalog->generation);
+    }
+}
+
 gboolean populate_list(gpointer user_data) {
     LauncherData *data = (LauncherData *)user_data;
+    if (current_catalog(data)) {
+        return G_SOURCE_REMOVE;
+    }
 
-    if (data->mode == MODE_RUN) {
-        // <<< FIX: Pass the rebuild_cache flag to the function
-        data->apps = get_run_executables(data->no_icons, data->rebuild_cache);
-    } else {
-        data->apps = get_applications(data->no_icons);
+    // The providers load in the background; this returns before any arrived.
+    data->catalogs[data->mode] = catalog_load(data->mode, data->no_icons, data->rebuild_cache,
+                                              on_filter_result, on_catalog_progress, data);
+    // A forced rebuild only applies to the first load.
+    data->rebuild_cache = FALSE;
+    // Also queues anything typed so far for the providers to run once loaded.
+    show_catalog(data);
+
+    return G_SOURCE_REMOVE;
+}
+
+// -----------------------------------------------------------------------------
+// Daemon Mode
+// -----------------------------------------------------------------------------
+
+// TRUE if what the catalog of mode was loaded from changed since. Each check
+// only stats files, so it is cheap enough to run on every hide. Launches
+// need no reload; the catalog reranks its entries in place as they happen.
+static gboolean catalog_is_outdated(LauncherMode mode) {
+    switch (mode) {
+        case MODE_DRUN:
+            return app_index_is_stale();
+        case MODE_RUN:
+            return run_cache_is_stale();
+        case MODE_FILES:
+            return file_index_needs_update();
+        default:
+            // The window list is fetched anew on every show anyway, and the
+            // emoji never change.
+            return FALSE;
+    }
+}
+
+// Swaps the replacement of mode in once every provider loaded and answered,
+// so the list never switches to a catalog that is still filling up. A
+// catalog on screen is kept until the window hides.
+static void adopt_reloaded(LauncherData *data, LauncherMode mode) {
+    Catalog *fresh = data->reloading[mode];
+    if (!fresh || !catalog_is_settled(fresh)) return;
+    if (mode == data->mode && gtk_widget_get_visible(GTK_WIDGET(data->window))) return;
+
+    Catalog *old = data->catalogs[mode];
+    data->catalogs[mode] = fresh;
+    data->reloading[mode] = NULL;
+    // The view must never point at entries that are about to be freed.
+    if (mode == data->mode) {
+        show_catalog(data);
     }
+    catalog_free(old);
+}
 
-    if (!data->apps) {
-        g_printerr("No items found for the selected mode.\n");
+// Starts reloading the outdated catalogs in the background while the window
+// is hidden, so the next show reflects new applications, $PATH changes and
+// new files. Until a replacement settles the old catalog stays.
+static gboolean reload_catalogs(gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    data->reload_source = 0;
+    if (gtk_widget_get_visible(GTK_WIDGET(data->window))) {
         return G_SOURCE_REMOVE;
     }
 
-    for (GSList *l = data->apps; l != NULL; l = l->next) {
-        AppInfo *app = (AppInfo *)l->data;
-        GtkWidget *row = gtk_list_box_row_new();
-        gtk_style_context_add_class(gtk_widget_get_style_context(row), "app-row");
-        g_object_set_data(G_OBJECT(row), "app-info", app);
+    for (gint mode = 0; mode < N_MODES; mode++) {
+        if (!data->catalogs[mode] || data->reloading[mode] || !catalog_is_outdated(mode)) continue;
+        // The empty query the replacement starts out with is also what it
+        // opens with, so it settles with its default order ready to show.
+        data->reloading[mode] = catalog_load(mode, data->no_icons, data->rebuild_cache,
+                                             on_filter_result, on_catalog_progress, data);
+    }
+    return G_SOURCE_REMOVE;
+}
 
-        GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-        gtk_style_context_add_class(gtk_widget_get_style_context(box), "app-row-box");
+void hide_launcher(LauncherData *data) {
+    gtk_widget_hide(GTK_WIDGET(data->window));
+    stop_prefetching(data);
+    // A replacement that settled while the list was on screen goes in now.
+    adopt_reloaded(data, data->mode);
+    if (!data->reload_source) {
+        data->reload_source = g_idle_add_full(G_PRIORITY_LOW, reload_catalogs, data, NULL);
+    }
+}
 
-        GtkWidget *icon = gtk_image_new_from_gicon(app->icon, GTK_ICON_SIZE_DIALOG);
-        gtk_style_context_add_class(gtk_widget_get_style_context(icon), "app-icon");
+void show_launcher(LauncherData *data, LauncherMode mode) {
+    // Whatever is still reloading shows on a later open; until then the
+    // previous catalog is complete and current enough.
+    adopt_reloaded(data, mode);
+
+    data->mode = mode;
+    g_signal_handlers_block_by_func(data->entry, on_search_changed, data);
+    gtk_entry_set_text(data->entry, "");
+    g_signal_handlers_unblock_by_func(data->entry, on_search_changed, data);
+
+    if (mode == MODE_WINDOWS) {
+        // Windows come and go without the launcher hearing of it, so their
+        // list is never reused. The old one is freed only once the view no
+        // longer points at it.
+        Catalog *old = data->catalogs[mode];
+        data->catalogs[mode] = NULL;
+        populate_list(data);
+        catalog_free(old);
+    } else if (current_catalog(data)) {
+        show_catalog(data);
+    } else {
+        populate_list(data);
+    }
 
-        GtkWidget *label = gtk_label_new(app->name);
-        gtk_label_set_xalign(GTK_LABEL(label), 0);
-        gtk_style_context_add_class(gtk_widget_get_style_context(label), "app-name");
+    gtk_widget_show_all(GTK_WIDGET(data->window));
+    gtk_widget_grab_focus(GTK_WIDGET(data->entry));
+    prefetch_most_frecent(data);
+    schedule_prefetch_selected(data);
+}
 
-        gtk_box_pack_start(GTK_BOX(box), icon, FALSE, FALSE, 0);
-        gtk_box_pack_start(GTK_BOX(box), label, TRUE, TRUE, 0);
-        gtk_container_add(GTK_CONTAINER(row), box);
-        gtk_list_box_insert(data->list_box, row, -1);
+// Runs one command line received from a client, e.g. "toggle drun".
+static void handle_command(LauncherData *data, const gchar *command) {
+    gchar **words = g_strsplit(command, " ", 3);
+    LauncherMode mode = data->mode;
+    if (words[0] && words[1]) {
+        mode = launcher_mode_from_string(words[1]);
     }
-
-    gtk_widget_show_all(GTK_WIDGET(data->list_box));
-    GtkListBoxRow *first_row = gtk_list_box_get_row_at_index(data->list_box, 0);
-    if (first_row) {
-        gtk_list_box_select_row(data->list_box, first_row);
+    gboolean visible = gtk_widget_get_visible(GTK_WIDGET(data->window));
+
+    if (g_strcmp0(words[0], "show") == 0) {
+        show_launcher(data, mode);
+    } else if (g_strcmp0(words[0], "hide") == 0) {
+        if (visible) hide_launcher(data);
+    } else if (g_strcmp0(words[0], "toggle") == 0) {
+        if (visible && mode == data->mode) {
+            hide_launcher(data);
+        } else {
+            show_launcher(data, mode);
+        }
+    } else if (g_strcmp0(words[0], "quit") == 0) {
+        gtk_main_quit();
+    } else {
+        g_warning("Unknown launcher command: %s", command);
     }
+    g_strfreev(words);
+}
 
-    return G_SOURCE_REMOVE;
+static gboolean on_socket_ready(gint fd, GIOCondition condition, gpointer user_data) {
+    LauncherData *data = (LauncherData *)user_data;
+    gchar *command;
+    while ((command = daemon_ipc_receive(fd)) != NULL) {
+        handle_command(data, command);
+        g_free(command);
+    }
+    return G_SOURCE_CONTINUE;
 }
 
 void create_launcher_window(LauncherData *data) {
@@ -426,22 +626,19 @@ void create_launcher_window(LauncherData *data) {
     gtk_style_context_add_class(gtk_widget_get_style_context(GTK_WIDGET(data->entry)), "input-entry");
     gtk_box_pack_start(GTK_BOX(main_container), GTK_WIDGET(data->entry), FALSE, FALSE, 0);
 
-    GtkWidget *scrolled_window = gtk_scrolled_window_new(NULL, NULL);
-    gtk_widget_set_app_paintable(scrolled_window, TRUE);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
-    gtk_style_context_add_class(gtk_widget_get_style_context(scrolled_window), "scrolled-window");
-    gtk_box_pack_start(GTK_BOX(main_container), scrolled_window, TRUE, TRUE, 0);
-
-    data->list_box = GTK_LIST_BOX(gtk_list_box_new());
-    gtk_style_context_add_class(gtk_widget_get_style_context(GTK_WIDGET(data->list_box)), "app-list");
-    gtk_list_box_set_selection_mode(GTK_LIST_BOX(data->list_box), GTK_SELECTION_SINGLE);
-    gtk_container_add(GTK_CONTAINER(scrolled_window), GTK_WIDGET(data->list_box));
+    // Icons are rasterized off the main thread and only for rows on screen.
+    if (!data->no_icons) {
+        gint width, height;
+        gtk_icon_size_lookup(GTK_ICON_SIZE_DIALOG, &width, &height);
+        data->icons = icon_loader_new(height, data->rebuild_cache, on_icons_ready, data);
+    }
+    data->result_view = result_view_new(data->icons, on_launch_app, data);
+    gtk_box_pack_start(GTK_BOX(main_container), result_view_get_widget(data->result_view), TRUE, TRUE, 0);
 
     g_signal_connect(data->window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
     g_signal_connect(data->window, "key-press-event", G_CALLBACK(on_key_press), data);
     g_signal_connect(data->entry, "changed", G_CALLBACK(on_search_changed), data);
     g_signal_connect(data->entry, "activate", G_CALLBACK(on_entry_activate), data);
-    g_signal_connect(data->list_box, "row-activated", G_CALLBACK(on_launch_app), data);
 }
 
 // -----------------------------------------------------------------------------
@@ -449,36 +646,110 @@ void create_launcher_window(LauncherData *data) {
 // -----------------------------------------------------------------------------
 
 int main(int argc, char *argv[]) {
-    FcInit();
-
     // <<< FIX: Argument parsing updated for --rebuild-cache >>>
     LauncherData *data = g_new0(LauncherData, 1);
     data->mode = MODE_DRUN;
     data->no_icons = FALSE;
     data->rebuild_cache = FALSE;
+    data->socket_fd = -1;
+    const gchar *command = NULL;
+    gboolean index_files = FALSE;
     for (int i = 1; i < argc; i++) {
-        if (g_strcmp0(argv[i], "run") == 0) {
-            data->mode = MODE_RUN;
+        if (argv[i][0] != '-') {
+            // A mode name such as "run" or "emoji"
+            data->mode = launcher_mode_from_string(argv[i]);
         } else if (g_strcmp0(argv[i], "--no-icons") == 0) {
             data->no_icons = TRUE;
         } else if (g_strcmp0(argv[i], "--rebuild-cache") == 0) {
             data->rebuild_cache = TRUE;
+        } else if (g_strcmp0(argv[i], "--index-files") == 0) {
+            index_files = TRUE;
+        } else if (g_strcmp0(argv[i], "--daemon") == 0) {
+            data->daemon = TRUE;
+        } else if (g_strcmp0(argv[i], "--toggle") == 0) {
+            command = "toggle";
+        } else if (g_strcmp0(argv[i], "--show") == 0) {
+            command = "show";
+        } else if (g_strcmp0(argv[i], "--hide") == 0) {
+            command = "hide";
+        } else if (g_strcmp0(argv[i], "--quit") == 0) {
+            command = "quit";
         }
     }
 
+    // Refreshes the file search index and exits, e.g. from a timer or exec-once.
+    if (index_files) {
+        gboolean ok = file_index_update(data->rebuild_cache);
+        g_free(data);
+        return ok ? 0 : 1;
+    }
+
+    // Thin client: hand the command to the daemon and exit without touching GTK.
+    if (command && !data->daemon) {
+        gchar *line = g_strdup_printf("%s %s", command, launcher_mode_to_string(data->mode));
+        gboolean sent = daemon_ipc_send(line);
+        if (!sent) {
+            g_printerr("No launcher daemon is running.\n");
+        }
+        g_free(line);
+        g_free(data);
+        return sent ? 0 : 1;
+    }
+
+    guint socket_source = 0;
+    if (data->daemon) {
+        data->socket_fd = daemon_ipc_listen();
+        if (data->socket_fd < 0) {
+            g_free(data);
+            return 1;
+        }
+    }
+
+    FcInit();
     gtk_init(&argc, &argv);
     load_css();
     create_launcher_window(data);
-
-    gtk_widget_show_all(GTK_WIDGET(data->window));
-    gtk_widget_grab_focus(GTK_WIDGET(data->entry));
-
-    g_idle_add(populate_list, data);
+    data->visible_ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+    data->prefetcher = prefetcher_new();
+
+    if (data->daemon) {
+        socket_source = g_unix_fd_add(data->socket_fd, G_IO_IN, on_socket_ready, data);
+        // Load the entries up front so that the first show is as fast as any other.
+        g_idle_add(populate_list, data);
+        if (g_strcmp0(command, "show") == 0 || g_strcmp0(command, "toggle") == 0) {
+            show_launcher(data, data->mode);
+        }
+    } else {
+        gtk_widget_show_all(GTK_WIDGET(data->window));
+        gtk_widget_grab_focus(GTK_WIDGET(data->entry));
+        g_idle_add(populate_list, data);
+    }
 
     gtk_main();
 
-    g_slist_free_full(data->apps, free_app_info);
+    if (!data->daemon) {
+        if (data->launch_time) {
+            g_debug("Launch timing: exiting after %.2f ms", (g_get_monotonic_time() - data->launch_time) / 1000.0);
+        }
+        // The process is about to end; tearing down a large catalog entry by
+        // entry would only hold back the exit.
+        return 0;
+    }
+
+    if (socket_source) g_source_remove(socket_source);
+    daemon_ipc_close(data->socket_fd);
+    if (data->reload_source) g_source_remove(data->reload_source);
+    stop_prefetching(data);
+    prefetcher_free(data->prefetcher);
+    result_view_free(data->result_view);
+    icon_loader_free(data->icons);
+    for (gint mode = 0; mode < N_MODES; mode++) {
+        catalog_free(data->reloading[mode]);
+        catalog_free(data->catalogs[mode]);
+    }
+    g_array_unref(data->visible_ids);
+    g_free(data->clipboard_text);
     g_free(data);
 
     return 0;
-}
\ No newline at end of file
+}
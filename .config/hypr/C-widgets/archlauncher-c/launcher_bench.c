@@ -0,0 +1,364 @@
+// Headless benchmark of the launcher's data side: loading entries, filtering
+// and ranking them, without GTK or a display.
+//
+// Every corpus runs in a child process of its own with a private $PATH, $HOME,
+// $XDG_CACHE_HOME and $XDG_DATA_HOME, so GLib's per-process caches start cold
+// and the peak RSS reported belongs to that corpus alone.
+//
+//   launcher-bench [--sizes 1000,10000,100000] [--modes run,drun,files]
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "app_info.h"
+#include "catalog.h"
+#include "history.h"
+
+#define DEFAULT_SIZES "1000,10000,100000"
+#define DEFAULT_MODES "run,drun"
+#define CORPUS_SEED 0x5eed
+#define TYPED_SESSIONS 24
+#define TYPED_PREFIX_MAX 10
+#define FILES_PER_DIR 64
+
+// Queries that match little or nothing, typed like any other session
+static const gchar *miss_queries[] = { "zzqx", "qwertyuiop", "xkcd" };
+
+// -----------------------------------------------------------------------------
+// Synthetic Corpora
+// -----------------------------------------------------------------------------
+
+static const gchar *syllables[] = {
+    "ka", "lo", "mi", "re", "tu", "xo", "zen", "bar", "cor", "dex", "fin", "gal",
+    "hub", "ix", "jet", "kit", "lux", "mon", "nav", "orb", "pix", "qua", "ray", "sol",
+};
+
+// A name like "corpix-sol3", deterministic for a given seed
+static gchar* synthetic_name(GRand *rand, guint index) {
+    GString *name = g_string_new(NULL);
+    gint n_syllables = g_rand_int_range(rand, 2, 5);
+    for (gint i = 0; i < n_syllables; i++) {
+        if (i > 0 && g_rand_int_range(rand, 0, 4) == 0) g_string_append_c(name, '-');
+        g_string_append(name, syllables[g_rand_int_range(rand, 0, G_N_ELEMENTS(syllables))]);
+    }
+    // The index keeps names unique however the syllables fall.
+    g_string_append_printf(name, "%u", index);
+    return g_string_free(name, FALSE);
+}
+
+// size empty files below $HOME, FILES_PER_DIR to a directory, in a two-level
+// tree like "sol/korbar12/dexmi345.txt"
+static gboolean write_file_corpus(guint size, const gchar *root) {
+    GRand *rand = g_rand_new_with_seed(CORPUS_SEED);
+    gchar *dir = NULL;
+    gboolean ok = TRUE;
+    for (guint i = 0; i < size && ok; i++) {
+        if (i % FILES_PER_DIR == 0) {
+            guint n_dir = i / FILES_PER_DIR;
+            gchar *dir_name = synthetic_name(rand, n_dir);
+            g_free(dir);
+            dir = g_build_filename(root, "home", syllables[n_dir % G_N_ELEMENTS(syllables)], dir_name, NULL);
+            g_mkdir_with_parents(dir, 0755);
+            g_free(dir_name);
+        }
+        gchar *name = synthetic_name(rand, i);
+        gchar *file_name = g_strconcat(name, ".txt", NULL);
+        gchar *path = g_build_filename(dir, file_name, NULL);
+        ok = g_file_set_contents(path, "", 0, NULL);
+        g_free(path);
+        g_free(file_name);
+        g_free(name);
+    }
+    g_free(dir);
+    g_rand_free(rand);
+    return ok;
+}
+
+static gboolean write_corpus(LauncherMode mode, guint size, const gchar *root) {
+    if (mode == MODE_FILES) {
+        return write_file_corpus(size, root);
+    }
+
+    gchar *dir = mode == MODE_RUN ? g_build_filename(root, "bin", NULL)
+                                  : g_build_filename(root, "data", "applications", NULL);
+    g_mkdir_with_parents(dir, 0755);
+    GRand *rand = g_rand_new_with_seed(CORPUS_SEED);
+    gboolean ok = TRUE;
+
+    for (guint i = 0; i < size && ok; i++) {
+        gchar *name = synthetic_name(rand, i);
+        gchar *path;
+        gchar *contents;
+        if (mode == MODE_RUN) {
+            path = g_build_filename(dir, name, NULL);
+            contents = g_strdup("");
+        } else {
+            gchar *file_name = g_strdup_printf("bench-%06u.desktop", i);
+            path = g_build_filename(dir, file_name, NULL);
+            contents = g_strdup_printf("[Desktop Entry]\nType=Application\nName=%s\nExec=%s %%U\n", name, name);
+            g_free(file_name);
+        }
+        ok = g_file_set_contents(path, contents, -1, NULL);
+        g_free(contents);
+        g_free(path);
+        g_free(name);
+    }
+
+    // Run mode also gets as many remembered command lines as executables.
+    if (ok && mode == MODE_RUN) {
+        GPtrArray *lines = g_ptr_array_new_with_free_func(g_free);
+        for (guint i = 0; i < size; i++) {
+            gchar *name = synthetic_name(rand, i);
+            g_ptr_array_add(lines, g_strdup_printf("%s --%s %u", name, syllables[i % G_N_ELEMENTS(syllables)], i));
+            g_free(name);
+        }
+        ok = history_save(lines);
+        g_ptr_array_unref(lines);
+    }
+
+    g_rand_free(rand);
+    g_free(dir);
+    return ok;
+}
+
+static void remove_tree(const gchar *path) {
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir))) {
+            gchar *child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+// -----------------------------------------------------------------------------
+// Measuring One Corpus (child process)
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    GMainLoop *loop;
+    guint waiting_for;   // Generation whose result ends the current wait
+} BenchState;
+
+// Merged results stream in per provider; a keystroke is done once all answered.
+static void on_result(FilterResult *result, gpointer user_data) {
+    Catalog *catalog = user_data;
+    BenchState *state = catalog->owner;
+    if (result->generation == state->waiting_for && catalog_is_settled(catalog)) {
+        g_main_loop_quit(state->loop);
+    }
+    filter_result_free(result);
+}
+
+static void on_progress(Catalog *catalog) {
+    BenchState *state = catalog->owner;
+    if (catalog->n_pending == 0) {
+        g_main_loop_quit(state->loop);
+    }
+}
+
+// Submits text and waits for its result. Returns the latency in milliseconds.
+static gdouble run_keystroke(BenchState *state, Catalog *catalog, const gchar *text) {
+    gint64 start = g_get_monotonic_time();
+    state->waiting_for = catalog_submit(catalog, text);
+    g_main_loop_run(state->loop);
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
+
+// Times a Tab completion of prefix. Returns the latency in milliseconds.
+static gdouble run_completion(Catalog *catalog, const gchar *prefix) {
+    gint64 start = g_get_monotonic_time();
+    g_free(catalog_complete(catalog, prefix));
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
+
+// Types text one character at a time, then deletes it again the same way.
+// Every prefix typed is also completed once.
+static void type_session(BenchState *state, Catalog *catalog, const gchar *text, GArray *latencies,
+                         GArray *completions) {
+    run_keystroke(state, catalog, "");
+    glong n_chars = MIN(g_utf8_strlen(text, -1), TYPED_PREFIX_MAX);
+    for (glong i = 1; i <= n_chars; i++) {
+        gchar *prefix = g_utf8_substring(text, 0, i);
+        gdouble ms = run_keystroke(state, catalog, prefix);
+        g_array_append_val(latencies, ms);
+        ms = run_completion(catalog, prefix);
+        g_array_append_val(completions, ms);
+        g_free(prefix);
+    }
+    for (glong i = n_chars - 1; i >= 0; i--) {
+        gchar *prefix = g_utf8_substring(text, 0, i);
+        gdouble ms = run_keystroke(state, catalog, prefix);
+        g_array_append_val(latencies, ms);
+        g_free(prefix);
+    }
+}
+
+static gint compare_doubles(gconstpointer a, gconstpointer b) {
+    gdouble x = *(const gdouble *)a;
+    gdouble y = *(const gdouble *)b;
+    return x < y ? -1 : (x > y);
+}
+
+static gdouble percentile(GArray *sorted, gdouble p) {
+    if (sorted->len == 0) return 0;
+    guint index = (guint)(p * (sorted->len - 1) + 0.5);
+    return g_array_index(sorted, gdouble, index);
+}
+
+// Loads the catalog and waits for every provider to arrive.
+static gdouble time_load(BenchState *state, LauncherMode mode, Catalog **out) {
+    gint64 start = g_get_monotonic_time();
+    *out = catalog_load(mode, TRUE, FALSE, on_result, on_progress, state);
+    g_main_loop_run(state->loop);
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
+
+// "desktop 12.34 ms" for every provider, in order of arrival
+static gchar* describe_providers(Catalog *catalog) {
+    GString *out = g_string_new(NULL);
+    for (guint i = 0; i < catalog->segments->len; i++) {
+        CatalogSegment *segment = g_ptr_array_index(catalog->segments, i);
+        g_string_append_printf(out, "%s%s %.2f ms", i > 0 ? ", " : "", segment->provider->name, segment->load_ms);
+    }
+    return g_string_free(out, FALSE);
+}
+
+static int run_corpus(LauncherMode mode, guint size, const gchar *root) {
+    if (!write_corpus(mode, size, root)) {
+        g_printerr("Failed to write the corpus to %s\n", root);
+        return 1;
+    }
+
+    BenchState state = { g_main_loop_new(NULL, FALSE), 0 };
+    Catalog *catalog;
+
+    // No cache exists yet, so this scans the corpus and writes the cache.
+    gdouble cold_ms = time_load(&state, mode, &catalog);
+    if (catalog->app_array->len == 0) {
+        g_printerr("The corpus produced no entries\n");
+        return 1;
+    }
+    gchar *cold_providers = describe_providers(catalog);
+    catalog_free(catalog);
+    gdouble warm_ms = time_load(&state, mode, &catalog);
+    gchar *warm_providers = describe_providers(catalog);
+
+    // Sessions type the start of names picked from the corpus itself.
+    GArray *latencies = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    GArray *completions = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    GRand *rand = g_rand_new_with_seed(CORPUS_SEED + size);
+    for (guint i = 0; i < TYPED_SESSIONS; i++) {
+        AppInfo *app = g_ptr_array_index(catalog->app_array, g_rand_int_range(rand, 0, catalog->app_array->len));
+        type_session(&state, catalog, app->name, latencies, completions);
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(miss_queries); i++) {
+        type_session(&state, catalog, miss_queries[i], latencies, completions);
+    }
+    g_array_sort(latencies, compare_doubles);
+    g_array_sort(completions, compare_doubles);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%-5s %7u  cold %9.2f ms  warm %8.2f ms  keystroke p50 %6.3f p90 %6.3f p99 %6.3f max %6.3f ms (n=%u)  peak RSS %6ld KiB\n",
+           launcher_mode_to_string(mode), catalog->app_array->len, cold_ms, warm_ms,
+           percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99),
+           percentile(latencies, 1.0), latencies->len, usage.ru_maxrss);
+    printf("      completion p50 %6.3f p99 %6.3f max %6.3f ms  providers cold: %s; warm: %s\n",
+           percentile(completions, 0.50), percentile(completions, 0.99), percentile(completions, 1.0),
+           cold_providers, warm_providers);
+    fflush(stdout);
+
+    g_free(warm_providers);
+    g_free(cold_providers);
+    g_rand_free(rand);
+    g_array_unref(completions);
+    g_array_unref(latencies);
+    catalog_free(catalog);
+    g_main_loop_unref(state.loop);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Driver (parent process)
+// -----------------------------------------------------------------------------
+
+static gboolean spawn_corpus(const gchar *mode, const gchar *size) {
+    gchar *root = g_dir_make_tmp("launcher-bench-XXXXXX", NULL);
+    if (!root) {
+        g_printerr("Failed to create a temporary directory\n");
+        return FALSE;
+    }
+
+    gchar **env = g_get_environ();
+    gchar *path = g_build_filename(root, "bin", NULL);
+    gchar *cache = g_build_filename(root, "cache", NULL);
+    gchar *data = g_build_filename(root, "data", NULL);
+    gchar *system = g_build_filename(root, "system", NULL);
+    gchar *home = g_build_filename(root, "home", NULL);
+    env = g_environ_setenv(env, "PATH", path, TRUE);
+    env = g_environ_setenv(env, "XDG_CACHE_HOME", cache, TRUE);
+    env = g_environ_setenv(env, "XDG_DATA_HOME", data, TRUE);
+    env = g_environ_setenv(env, "XDG_DATA_DIRS", system, TRUE);
+    env = g_environ_setenv(env, "HOME", home, TRUE);
+
+    gchar *argv[] = { "/proc/self/exe", "--corpus", (gchar *)mode, (gchar *)size, root, NULL };
+    gint status = 0;
+    GError *error = NULL;
+    gboolean ok = g_spawn_sync(NULL, argv, env, G_SPAWN_DEFAULT, NULL, NULL,
+                               NULL, NULL, &status, &error);
+    if (!ok) {
+        g_printerr("Failed to run the %s corpus of %s: %s\n", mode, size, error->message);
+        g_error_free(error);
+    } else {
+        ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    remove_tree(root);
+    g_free(home);
+    g_free(system);
+    g_free(data);
+    g_free(cache);
+    g_free(path);
+    g_strfreev(env);
+    g_free(root);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 5 && g_strcmp0(argv[1], "--corpus") == 0) {
+        LauncherMode mode = launcher_mode_from_string(argv[2]);
+        return run_corpus(mode, (guint)g_ascii_strtoull(argv[3], NULL, 10), argv[4]);
+    }
+
+    const gchar *sizes_arg = DEFAULT_SIZES;
+    const gchar *modes_arg = DEFAULT_MODES;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (g_strcmp0(argv[i], "--sizes") == 0) {
+            sizes_arg = argv[i + 1];
+        } else if (g_strcmp0(argv[i], "--modes") == 0) {
+            modes_arg = argv[i + 1];
+        }
+    }
+
+    gchar **sizes = g_strsplit(sizes_arg, ",", 0);
+    gchar **modes = g_strsplit(modes_arg, ",", 0);
+    gboolean ok = TRUE;
+    for (int m = 0; modes[m] != NULL; m++) {
+        for (int s = 0; sizes[s] != NULL; s++) {
+            ok = spawn_corpus(modes[m], sizes[s]) && ok;
+        }
+    }
+    g_strfreev(modes);
+    g_strfreev(sizes);
+    return ok ? 0 : 1;
+}
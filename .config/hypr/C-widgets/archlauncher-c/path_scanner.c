@@ -0,0 +1,109 @@
+#include "path_scanner.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SCANNER_MAX_THREADS 4
+#define SCANNER_BUFFER_SIZE (32 * 1024)
+
+// Record layout returned by the getdents64 syscall
+struct linux_dirent64 {
+    guint64 d_ino;
+    gint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// One directory to scan and the slot its result goes into
+typedef struct {
+    const gchar *dir_path;
+    GPtrArray *names;
+} ScanJob;
+
+// Only used when d_type can't tell us what the entry is (symlinks, or
+// filesystems that report DT_UNKNOWN). Follows symlinks.
+static gboolean is_executable_at(int dir_fd, const char *name) {
+    struct stat st;
+    if (fstatat(dir_fd, name, &st, 0) != 0) return FALSE;
+    return S_ISREG(st.st_mode) && (st.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH));
+}
+
+// Reads one directory with getdents64 and keeps the executables. Regular files
+// are taken on d_type alone: everything in a $PATH directory is meant to be run,
+// so stat'ing thousands of them just to re-check the x bit isn't worth it.
+static void scan_dir(ScanJob *job) {
+    int dir_fd = open(job->dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return;
+
+    char *buffer = g_malloc(SCANNER_BUFFER_SIZE);
+    for (;;) {
+        long n_read = syscall(SYS_getdents64, dir_fd, buffer, SCANNER_BUFFER_SIZE);
+        if (n_read <= 0) break;
+
+        for (long offset = 0; offset < n_read; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)(buffer + offset);
+            offset += entry->d_reclen;
+
+            const char *name = entry->d_name;
+            // Names that would break the line-based RUN cache are skipped as well.
+            if (name[0] == '.' || strchr(name, '\n')) continue;
+
+            gboolean executable;
+            switch (entry->d_type) {
+                case DT_REG:
+                    executable = TRUE;
+                    break;
+                case DT_LNK:
+                case DT_UNKNOWN:
+                    executable = is_executable_at(dir_fd, name);
+                    break;
+                default:
+                    executable = FALSE;
+                    break;
+            }
+            if (executable) {
+                g_ptr_array_add(job->names, g_strdup(name));
+            }
+        }
+    }
+    g_free(buffer);
+    close(dir_fd);
+}
+
+static void scan_dir_worker(gpointer data, gpointer user_data) {
+    (void)user_data;
+    scan_dir(data);
+}
+
+GPtrArray* path_scanner_scan(const gchar * const *dirs, guint n_dirs) {
+    GPtrArray *results = g_ptr_array_new_full(n_dirs, (GDestroyNotify)g_ptr_array_unref);
+    ScanJob *jobs = g_new(ScanJob, n_dirs);
+    for (guint i = 0; i < n_dirs; i++) {
+        jobs[i].dir_path = dirs[i];
+        jobs[i].names = g_ptr_array_new_with_free_func(g_free);
+        g_ptr_array_add(results, jobs[i].names);
+    }
+
+    // Every job writes only into its own slot, so the results keep $PATH order
+    // no matter which worker finishes first.
+    gint n_threads = MIN((gint)n_dirs, MIN((gint)g_get_num_processors(), SCANNER_MAX_THREADS));
+    GThreadPool *pool = n_threads > 1 ? g_thread_pool_new(scan_dir_worker, NULL, n_threads, FALSE, NULL) : NULL;
+    if (pool) {
+        for (guint i = 0; i < n_dirs; i++) {
+            g_thread_pool_push(pool, &jobs[i], NULL);
+        }
+        // Waits for all queued jobs to finish.
+        g_thread_pool_free(pool, FALSE, TRUE);
+    } else {
+        for (guint i = 0; i < n_dirs; i++) {
+            scan_dir(&jobs[i]);
+        }
+    }
+
+    g_free(jobs);
+    return results;
+}
@@ -0,0 +1,12 @@
+#ifndef PATH_SCANNER_H
+#define PATH_SCANNER_H
+
+#include <glib.h>
+
+// Lists the executables in each of the given directories, scanning the
+// directories concurrently on a small worker pool. Returns one GPtrArray of
+// names per input directory, in the same order as dirs; unreadable
+// directories yield an empty array. Free with g_ptr_array_unref().
+GPtrArray* path_scanner_scan(const gchar * const *dirs, guint n_dirs);
+
+#endif // PATH_SCANNER_H
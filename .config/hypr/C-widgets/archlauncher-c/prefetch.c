@@ -0,0 +1,275 @@
+#define _GNU_SOURCE // readahead()
+#include "prefetch.h"
+#include <elf.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PREFETCH_RATE        (32 * 1024 * 1024) // Bytes per second read ahead at most
+#define PREFETCH_CHUNK       (1024 * 1024)      // Bytes read per readahead() call
+#define PREFETCH_MAX_FILES   32                 // A program and its libraries, per request
+#define PREFETCH_SLEEP_SLICE (20 * 1000)        // Microseconds between checks for cancellation
+
+// Where DT_NEEDED libraries are looked up. Arch keeps all of them in /usr/lib.
+static const gchar *library_dirs[] = { "/usr/lib", "/usr/lib64", "/lib", "/lib64", "/usr/local/lib" };
+
+// A program to prefetch. path == NULL asks the thread to exit.
+typedef struct {
+    guint generation;
+    gchar *path;
+} PrefetchJob;
+
+struct _Prefetcher {
+    GThread *thread;
+    GAsyncQueue *jobs;
+    gint generation;         // Bumped by prefetcher_cancel(), accessed atomically
+
+    // Worker-thread-only
+    guint seen_generation;   // The generation seen belongs to
+    GHashTable *seen;        // Files already handled in that generation
+    gint64 next_chunk_time;  // Earliest monotonic time the rate allows the next chunk at
+    guint64 session_bytes;   // Read ahead in that generation
+};
+
+static void prefetch_job_free(PrefetchJob *job) {
+    g_free(job->path);
+    g_free(job);
+}
+
+static gboolean is_stale(Prefetcher *prefetcher, guint generation) {
+    return (guint)g_atomic_int_get(&prefetcher->generation) != generation;
+}
+
+// Waits until the rate limit allows another chunk. Returns FALSE if the
+// request was cancelled meanwhile.
+static gboolean wait_for_budget(Prefetcher *prefetcher, guint generation) {
+    for (;;) {
+        if (is_stale(prefetcher, generation)) return FALSE;
+        gint64 wait = prefetcher->next_chunk_time - g_get_monotonic_time();
+        if (wait <= 0) return TRUE;
+        g_usleep(MIN(wait, PREFETCH_SLEEP_SLICE));
+    }
+}
+
+static void charge_budget(Prefetcher *prefetcher, guint64 bytes) {
+    gint64 now = g_get_monotonic_time();
+    prefetcher->next_chunk_time = MAX(now, prefetcher->next_chunk_time) + (gint64)(bytes * G_USEC_PER_SEC / PREFETCH_RATE);
+}
+
+// -----------------------------------------------------------------------------
+// Libraries
+// -----------------------------------------------------------------------------
+
+// Translates a virtual address of an ELF image to its offset in the file.
+static gboolean elf_file_offset(const Elf64_Phdr *phdrs, guint n_phdrs, guint64 vaddr, guint64 *offset) {
+    for (guint i = 0; i < n_phdrs; i++) {
+        if (phdrs[i].p_type == PT_LOAD && vaddr >= phdrs[i].p_vaddr && vaddr - phdrs[i].p_vaddr < phdrs[i].p_filesz) {
+            *offset = vaddr - phdrs[i].p_vaddr + phdrs[i].p_offset;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Adds the libraries a 64-bit ELF file links against (its DT_NEEDED entries)
+// to files, unless seen already. Scripts, static programs and anything
+// malformed add nothing.
+static void add_needed_libraries(const guint8 *map, gsize size, GPtrArray *files, GHashTable *seen) {
+    if (size < sizeof(Elf64_Ehdr) || memcmp(map, ELFMAG, SELFMAG) != 0 || map[EI_CLASS] != ELFCLASS64) return;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)map;
+    if (ehdr->e_phentsize != sizeof(Elf64_Phdr) || ehdr->e_phoff > size ||
+        (guint64)ehdr->e_phnum * sizeof(Elf64_Phdr) > size - ehdr->e_phoff) {
+        return;
+    }
+    const Elf64_Phdr *phdrs = (const Elf64_Phdr *)(map + ehdr->e_phoff);
+
+    const Elf64_Dyn *dyn = NULL;
+    guint64 n_dyn = 0;
+    for (guint i = 0; i < ehdr->e_phnum; i++) {
+        if (phdrs[i].p_type == PT_DYNAMIC && phdrs[i].p_offset <= size && phdrs[i].p_filesz <= size - phdrs[i].p_offset) {
+            dyn = (const Elf64_Dyn *)(map + phdrs[i].p_offset);
+            n_dyn = phdrs[i].p_filesz / sizeof(Elf64_Dyn);
+        }
+    }
+    if (!dyn) return;
+
+    guint64 strtab_vaddr = 0;
+    guint64 strtab_size = 0;
+    for (guint64 i = 0; i < n_dyn && dyn[i].d_tag != DT_NULL; i++) {
+        if (dyn[i].d_tag == DT_STRTAB) strtab_vaddr = dyn[i].d_un.d_ptr;
+        if (dyn[i].d_tag == DT_STRSZ) strtab_size = dyn[i].d_un.d_val;
+    }
+    guint64 strtab_offset;
+    if (!elf_file_offset(phdrs, ehdr->e_phnum, strtab_vaddr, &strtab_offset) || strtab_offset > size ||
+        strtab_size > size - strtab_offset) {
+        return;
+    }
+    const gchar *strings = (const gchar *)map + strtab_offset;
+
+    for (guint64 i = 0; i < n_dyn && dyn[i].d_tag != DT_NULL; i++) {
+        if (dyn[i].d_tag != DT_NEEDED || dyn[i].d_un.d_val >= strtab_size) continue;
+        const gchar *name = strings + dyn[i].d_un.d_val;
+        if (!memchr(name, '\0', strtab_size - dyn[i].d_un.d_val) || strchr(name, '/')) continue;
+
+        for (guint j = 0; j < G_N_ELEMENTS(library_dirs) && files->len < PREFETCH_MAX_FILES; j++) {
+            gchar *path = g_build_filename(library_dirs[j], name, NULL);
+            if (g_file_test(path, G_FILE_TEST_IS_REGULAR)) {
+                if (g_hash_table_add(seen, g_strdup(path))) {
+                    g_ptr_array_add(files, path);
+                } else {
+                    g_free(path);
+                }
+                break;
+            }
+            g_free(path);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Worker Thread
+// -----------------------------------------------------------------------------
+
+// Reads the pages of path that are not cached yet and adds the libraries it
+// needs to files. Returns the number of bytes read ahead.
+static guint64 prefetch_file(Prefetcher *prefetcher, guint generation, const gchar *path, GPtrArray *files) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    gsize size = st.st_size;
+    guint8 *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+
+    // Looked at before the ELF headers are read, which pulls in their pages.
+    gsize page_size = sysconf(_SC_PAGESIZE);
+    gsize n_pages = (size + page_size - 1) / page_size;
+    guchar *resident = g_malloc(n_pages);
+    if (mincore(map, size, resident) != 0) {
+        memset(resident, 0, n_pages);
+    }
+    add_needed_libraries(map, size, files, prefetcher->seen);
+    munmap(map, size);
+
+    guint64 fetched = 0;
+    gsize pages_per_chunk = MAX(PREFETCH_CHUNK / page_size, 1);
+    for (gsize first = 0; first < n_pages; first += pages_per_chunk) {
+        gsize end = MIN(first + pages_per_chunk, n_pages);
+        gsize missing = 0;
+        for (gsize i = first; i < end; i++) {
+            if (!(resident[i] & 1)) missing++;
+        }
+        if (missing == 0) continue;
+        if (!wait_for_budget(prefetcher, generation)) break;
+
+        readahead(fd, (off64_t)first * page_size, (end - first) * page_size);
+        charge_budget(prefetcher, (guint64)missing * page_size);
+        fetched += (guint64)missing * page_size;
+    }
+
+    g_free(resident);
+    close(fd);
+    return fetched;
+}
+
+static void run_job(Prefetcher *prefetcher, PrefetchJob *job) {
+    gint64 start = g_get_monotonic_time();
+    // Programs in $PATH are often symlinks to the real binary.
+    gchar *real_path = realpath(job->path, NULL);
+    const gchar *path = real_path ? real_path : job->path;
+    if (!g_hash_table_add(prefetcher->seen, g_strdup(path))) {
+        free(real_path);
+        return;
+    }
+
+    GPtrArray *files = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(files, g_strdup(path));
+    free(real_path);
+
+    // files grows while it is walked, as the libraries of libraries come in.
+    guint64 fetched = 0;
+    guint n_done = 0;
+    for (; n_done < files->len && !is_stale(prefetcher, job->generation); n_done++) {
+        fetched += prefetch_file(prefetcher, job->generation, g_ptr_array_index(files, n_done), files);
+    }
+    prefetcher->session_bytes += fetched;
+
+    g_debug("Prefetch: %s and %u libraries, %" G_GUINT64_FORMAT " KiB read ahead in %.2f ms%s "
+            "(%" G_GUINT64_FORMAT " KiB since shown)",
+            (const gchar *)g_ptr_array_index(files, 0), n_done > 0 ? n_done - 1 : 0, fetched / 1024,
+            (g_get_monotonic_time() - start) / 1000.0, n_done < files->len ? ", cancelled" : "",
+            prefetcher->session_bytes / 1024);
+    g_ptr_array_unref(files);
+}
+
+static gpointer prefetch_thread_func(gpointer user_data) {
+    Prefetcher *prefetcher = user_data;
+
+    for (;;) {
+        PrefetchJob *job = g_async_queue_pop(prefetcher->jobs);
+        if (!job->path) {
+            prefetch_job_free(job);
+            break;
+        }
+        if (job->generation != prefetcher->seen_generation) {
+            // A new showing of the launcher: what the last one prefetched may
+            // have been evicted since.
+            g_hash_table_remove_all(prefetcher->seen);
+            prefetcher->seen_generation = job->generation;
+            prefetcher->session_bytes = 0;
+        }
+        if (!is_stale(prefetcher, job->generation)) {
+            run_job(prefetcher, job);
+        }
+        prefetch_job_free(job);
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+Prefetcher* prefetcher_new(void) {
+    Prefetcher *prefetcher = g_new0(Prefetcher, 1);
+    prefetcher->jobs = g_async_queue_new();
+    prefetcher->seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    prefetcher->thread = g_thread_new("launcher-prefetch", prefetch_thread_func, prefetcher);
+    return prefetcher;
+}
+
+void prefetcher_request(Prefetcher *prefetcher, const gchar *path) {
+    PrefetchJob *job = g_new(PrefetchJob, 1);
+    job->generation = g_atomic_int_get(&prefetcher->generation);
+    job->path = g_strdup(path);
+    g_async_queue_push(prefetcher->jobs, job);
+}
+
+void prefetcher_cancel(Prefetcher *prefetcher) {
+    g_atomic_int_inc(&prefetcher->generation);
+}
+
+void prefetcher_free(Prefetcher *prefetcher) {
+    if (!prefetcher) return;
+    prefetcher_cancel(prefetcher);
+    PrefetchJob *quit = g_new0(PrefetchJob, 1);
+    g_async_queue_push(prefetcher->jobs, quit);
+    g_thread_join(prefetcher->thread);
+
+    PrefetchJob *job;
+    while ((job = g_async_queue_try_pop(prefetcher->jobs))) {
+        prefetch_job_free(job);
+    }
+    g_async_queue_unref(prefetcher->jobs);
+    g_hash_table_destroy(prefetcher->seen);
+    g_free(prefetcher);
+}
@@ -0,0 +1,23 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <glib.h>
+
+// Reads programs the user is likely to launch, and the libraries they link
+// against, into the page cache ahead of time, on a thread of its own and at
+// a limited rate. Only pages not already cached are read. Run with
+// G_MESSAGES_DEBUG=all to see how many bytes every request brought in.
+typedef struct _Prefetcher Prefetcher;
+
+Prefetcher* prefetcher_new(void);
+
+// Queues the program at path (and its libraries) for prefetching.
+void prefetcher_request(Prefetcher *prefetcher, const gchar *path);
+
+// Drops the queued requests and stops the running one at its next chunk.
+void prefetcher_cancel(Prefetcher *prefetcher);
+
+// Cancels outstanding work, joins the thread and frees the prefetcher.
+void prefetcher_free(Prefetcher *prefetcher);
+
+#endif // PREFETCH_H
@@ -0,0 +1,269 @@
+#include "provider.h"
+#include "app_index.h"
+#include "app_info.h"
+#include "file_index.h"
+#include "frecency.h"
+#include "history.h"
+#include "hypr_ipc.h"
+#include "run_cache.h"
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Desktop Applications
+// -----------------------------------------------------------------------------
+
+// Returns the sorted list of all .desktop applications, served from the
+// memory-mapped DRUN index unless one of the applications directories changed.
+static GSList* load_applications(gboolean no_icons, gboolean rebuild_cache) {
+    return app_index_load(no_icons, rebuild_cache);
+}
+
+const Provider desktop_provider = {
+    .name = "desktop",
+    .frecency_file = FRECENCY_DRUN_FILE,
+    .launch_kind = LAUNCH_DESKTOP_ENTRY,
+    .load = load_applications,
+};
+
+// -----------------------------------------------------------------------------
+// $PATH Executables
+// -----------------------------------------------------------------------------
+
+// Returns the sorted list of executables in $PATH. The per-directory cache in
+// run_cache.c only rescans the $PATH directories whose mtime changed. Each
+// entry keeps the path it was found at, so launching it needs no search.
+static GSList* load_run_executables(gboolean no_icons, gboolean rebuild_cache) {
+    GSList *apps = NULL;
+    GPtrArray *executables = run_cache_load(rebuild_cache);
+    if (!executables) {
+        return NULL;
+    }
+
+    GIcon *generic_icon = no_icons ? NULL : g_themed_icon_new("utilities-terminal");
+    for (guint i = 0; i < executables->len; i++) {
+        gchar *path = g_ptr_array_index(executables, i);
+        const gchar *name = strrchr(path, '/') + 1;
+        AppInfo *app = app_info_new(name, name, generic_icon);
+        // Relative $PATH entries would resolve against the child's directory.
+        if (g_path_is_absolute(path)) {
+            app->path = path;
+            executables->pdata[i] = NULL;
+        }
+        apps = g_slist_prepend(apps, app);
+    }
+    if (generic_icon) {
+        g_object_unref(generic_icon);
+    }
+    g_ptr_array_unref(executables);
+
+    return g_slist_sort(apps, compare_apps);
+}
+
+const Provider path_provider = {
+    .name = "path",
+    .frecency_file = FRECENCY_RUN_FILE,
+    .launch_kind = LAUNCH_PROGRAM,
+    .load = load_run_executables,
+};
+
+// -----------------------------------------------------------------------------
+// Command History
+// -----------------------------------------------------------------------------
+
+// Returns the command lines run from the launcher. The history file is
+// already in compare_apps() order, so nothing needs sorting.
+static GSList* load_history(gboolean no_icons, gboolean rebuild_cache) {
+    History *history = history_load();
+    GSList *apps = NULL;
+    GIcon *history_icon = no_icons ? NULL : g_themed_icon_new("document-open-recent");
+    for (guint i = history_get_n_lines(history); i > 0; i--) {
+        const gchar *line = history_get_line(history, i - 1);
+        apps = g_slist_prepend(apps, app_info_new(line, line, history_icon));
+    }
+    if (history_icon) {
+        g_object_unref(history_icon);
+    }
+    history_free(history);
+    return apps;
+}
+
+const Provider history_provider = {
+    .name = "history",
+    .frecency_file = FRECENCY_HISTORY_FILE,
+    .launch_kind = LAUNCH_COMMAND_LINE,
+    .load = load_history,
+};
+
+// -----------------------------------------------------------------------------
+// Hyprland Windows
+// -----------------------------------------------------------------------------
+
+// Switcher order: the window focused before the current one comes first, so
+// Enter alone goes back to it, and the current window comes last.
+static gint compare_focus(gconstpointer a, gconstpointer b) {
+    const HyprClient *client_a = *(const HyprClient * const *)a;
+    const HyprClient *client_b = *(const HyprClient * const *)b;
+    gint rank_a = client_a->focus_history_id == 0 ? G_MAXINT : client_a->focus_history_id;
+    gint rank_b = client_b->focus_history_id == 0 ? G_MAXINT : client_b->focus_history_id;
+    return rank_a < rank_b ? -1 : (rank_a > rank_b);
+}
+
+static GSList* load_windows(gboolean no_icons, gboolean rebuild_cache) {
+    GPtrArray *clients = hypr_ipc_get_clients();
+    if (!clients) {
+        return NULL;
+    }
+    g_ptr_array_sort(clients, compare_focus);
+
+    GSList *apps = NULL;
+    for (guint i = clients->len; i > 0; i--) {
+        HyprClient *client = g_ptr_array_index(clients, i - 1);
+        if (!client->mapped || client->hidden) continue;
+
+        const gchar *class_name = client->class_name ? client->class_name : "";
+        const gchar *title = client->title && client->title[0] != '\0' ? client->title : class_name;
+        gchar *name = class_name[0] != '\0' && title != class_name
+                          ? g_strdup_printf("%s \u2014 %s", title, class_name)
+                          : g_strdup(title[0] != '\0' ? title : client->address);
+
+        // Most applications name their icon after their class.
+        GIcon *icon = NULL;
+        if (!no_icons && class_name[0] != '\0') {
+            gchar *icon_name = g_ascii_strdown(class_name, -1);
+            icon = g_themed_icon_new_with_default_fallbacks(icon_name);
+            g_free(icon_name);
+        }
+        apps = g_slist_prepend(apps, app_info_new(name, client->address, icon));
+        if (icon) {
+            g_object_unref(icon);
+        }
+        g_free(name);
+    }
+    g_ptr_array_unref(clients);
+    return apps;
+}
+
+const Provider window_provider = {
+    .name = "windows",
+    .frecency_file = NULL,
+    .launch_kind = LAUNCH_WINDOW,
+    .keep_order = TRUE,
+    .load = load_windows,
+};
+
+// -----------------------------------------------------------------------------
+// Files
+// -----------------------------------------------------------------------------
+
+// Icons go by file type, and the type by extension, so a handful of lookups
+// serve the whole index.
+static GIcon* icon_for_file(GHashTable *icons, const gchar *path) {
+    const gchar *slash = strrchr(path, '/');
+    const gchar *base_name = slash ? slash + 1 : path;
+    const gchar *extension = strrchr(base_name, '.');
+    GIcon *icon = g_hash_table_lookup(icons, extension ? extension : "");
+    if (!icon) {
+        gchar *content_type = g_content_type_guess(base_name, NULL, 0, NULL);
+        icon = g_content_type_get_icon(content_type);
+        g_hash_table_insert(icons, g_strdup(extension ? extension : ""), icon);
+        g_free(content_type);
+    }
+    return icon;
+}
+
+// Returns every file and directory in the index, in index order: each
+// directory followed by its contents. The index is refreshed first when it is
+// missing or old, which only reads the directories that changed. Each path is
+// decoded once, straight into the arena, and doubles as the entry's exec.
+static AppArena* load_files(gboolean no_icons, gboolean rebuild_cache) {
+    if (rebuild_cache || file_index_needs_update()) {
+        file_index_update(rebuild_cache);
+    }
+    FileIndex *index = file_index_open();
+    if (!index) {
+        return NULL;
+    }
+
+    GHashTable *icons = no_icons ? NULL : g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+    GIcon *folder_icon = no_icons ? NULL : g_themed_icon_new("folder");
+    AppArena *arena = app_arena_new();
+    FileIndexIter iter;
+    file_index_iter_init(index, &iter);
+    while (file_index_iter_next(&iter)) {
+        // The home directory itself
+        if (iter.length == 0) continue;
+        GIcon *icon = no_icons ? NULL : iter.is_dir ? folder_icon : icon_for_file(icons, iter.path);
+        app_arena_add(arena, iter.path, iter.length, icon);
+    }
+    if (folder_icon) {
+        g_object_unref(folder_icon);
+    }
+    if (icons) {
+        g_hash_table_destroy(icons);
+    }
+    file_index_free(index);
+    if (app_arena_get_apps(arena)->len == 0) {
+        app_arena_free(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+const Provider file_provider = {
+    .name = "files",
+    .frecency_file = FRECENCY_FILES_FILE,
+    .launch_kind = LAUNCH_FILE,
+    .keep_order = TRUE,
+    .load_arena = load_files,
+};
+
+// -----------------------------------------------------------------------------
+// Emoji
+// -----------------------------------------------------------------------------
+
+// Returns the emoji of EMOJI_FILE in file order, which groups them the way
+// the Unicode emoji charts do. Every line holds the glyph, the emoji version
+// it appeared in and its name: "😀 E1.0 grinning face". An entry's name is the
+// glyph and the name, its exec the glyph alone.
+static GSList* load_emoji(gboolean no_icons, gboolean rebuild_cache) {
+    GError *error = NULL;
+    GMappedFile *mapped = g_mapped_file_new(EMOJI_FILE, FALSE, &error);
+    if (!mapped) {
+        g_warning("Failed to open the emoji list: %s", error->message);
+        g_error_free(error);
+        return NULL;
+    }
+
+    const gchar *cursor = g_mapped_file_get_contents(mapped);
+    const gchar *end = cursor + g_mapped_file_get_length(mapped);
+    GSList *apps = NULL;
+    while (cursor < end) {
+        const gchar *newline = memchr(cursor, '\n', end - cursor);
+        const gchar *line_end = newline ? newline : end;
+        const gchar *space = memchr(cursor, ' ', line_end - cursor);
+        if (space && space > cursor) {
+            const gchar *name = space + 1;
+            // The version only gets in the way of searching.
+            if (line_end - name > 1 && name[0] == 'E' && g_ascii_isdigit(name[1])) {
+                const gchar *next = memchr(name, ' ', line_end - name);
+                name = next ? next + 1 : line_end;
+            }
+            gchar *glyph = g_strndup(cursor, space - cursor);
+            gchar *label = g_strdup_printf("%s  %.*s", glyph, (int)(line_end - name), name);
+            apps = g_slist_prepend(apps, app_info_new(label, glyph, NULL));
+            g_free(label);
+            g_free(glyph);
+        }
+        cursor = newline ? newline + 1 : end;
+    }
+    g_mapped_file_unref(mapped);
+    return g_slist_reverse(apps);
+}
+
+const Provider emoji_provider = {
+    .name = "emoji",
+    .frecency_file = FRECENCY_EMOJI_FILE,
+    .launch_kind = LAUNCH_COPY,
+    .keep_order = TRUE,
+    .load = load_emoji,
+};
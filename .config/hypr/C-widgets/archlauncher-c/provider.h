@@ -0,0 +1,48 @@
+#ifndef PROVIDER_H
+#define PROVIDER_H
+
+#include <glib.h>
+#include "app_info.h"
+#include "launch.h"
+
+// A source of launcher entries. A mode shows the merged entries of one or
+// more providers, each loaded on a thread of its own, so a slow provider only
+// delays its own entries.
+typedef struct {
+    const gchar *name;          // Shown in timing logs
+    const gchar *frecency_file; // Launch history of its entries inside ~/.cache/cachy/, or NULL
+    LaunchKind launch_kind;     // What the exec strings of its entries hold
+    gboolean keep_order;        // Entries come in display order instead of by name
+
+    // Returns the entries as AppInfo, sorted with compare_apps() unless
+    // keep_order is set, or NULL if there are none. Runs on a worker thread,
+    // so it must not touch GTK.
+    GSList* (*load)(gboolean no_icons, gboolean rebuild_cache);
+
+    // Like load, but returns the entries in an AppArena. Set instead of load
+    // by providers with entries by the hundred thousand.
+    AppArena* (*load_arena)(gboolean no_icons, gboolean rebuild_cache);
+} Provider;
+
+// .desktop applications, served from the DRUN index
+extern const Provider desktop_provider;
+
+// Executables in $PATH, served from the RUN cache
+extern const Provider path_provider;
+
+// Command lines run from the launcher, served from the sorted history file
+extern const Provider history_provider;
+
+// Open Hyprland windows, fetched over its IPC socket, most recently used first
+extern const Provider window_provider;
+
+// Files and directories below $HOME, served from the file search index
+extern const Provider file_provider;
+
+// The emoji list, relative to the launcher directory like launcher.css
+#define EMOJI_FILE "../../scripts/emoji.txt"
+
+// Emoji and their names, read from the memory-mapped EMOJI_FILE
+extern const Provider emoji_provider;
+
+#endif // PROVIDER_H
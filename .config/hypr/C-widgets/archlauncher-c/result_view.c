@@ -0,0 +1,443 @@
+#include "result_view.h"
+#include <string.h>
+
+// Upper bound on row widgets, however tall the window gets
+#define MAX_SLOTS 64
+// Items scrolled per mouse wheel notch
+#define WHEEL_STEP 3
+
+struct _ResultView {
+    GtkWidget *widget;         // Box holding the viewport and the scrollbar
+    GtkWidget *scrolled;       // Clips the rows to the height the window gives it
+    GtkWidget *event_box;      // Catches scroll events before the scrolled window does
+    GtkListBox *list_box;
+    GtkWidget *scrollbar;
+    GtkAdjustment *adjustment; // Counted in items; the value is the first item shown
+    GPtrArray *slots;          // The recycled GtkListBoxRow, top to bottom
+    IconLoader *icons;         // NULL without icons
+    ResultViewActivateFunc activate;
+    gpointer user_data;
+
+    GPtrArray *apps;
+    GArray *items;             // guint32 positions in apps, in display order
+    FuzzyQuery query;
+    guint generation;          // Of the query the items answer
+    guint offset;              // Item bound to the first slot
+    guint n_visible;           // Rows that fit completely
+    gint selected;             // Selected item, -1 if none
+    gint viewport_height;
+    gdouble scroll_delta;      // Smooth-scroll distance not yet turned into items
+    gboolean updating;         // Set while the view itself moves the adjustment
+    guint layout_source;
+};
+
+static guint n_items(ResultView *view) {
+    return view->items->len;
+}
+
+// -----------------------------------------------------------------------------
+// Rows
+// -----------------------------------------------------------------------------
+
+// Bolds the matched characters of a row's label. Consecutive positions are
+// merged into one attribute; continuation bytes of UTF-8 characters are skipped
+// since the lead byte's range already covers them.
+static void set_match_highlight(GtkLabel *label, const gchar *text, const guint *positions, gsize n_positions) {
+    PangoAttrList *attrs = pango_attr_list_new();
+    PangoAttribute *current = NULL;
+
+    for (gsize i = 0; i < n_positions; i++) {
+        guint start = positions[i];
+        if (((guchar)text[start] & 0xC0) == 0x80) continue;
+        guint end = g_utf8_next_char(text + start) - text;
+
+        if (current && current->end_index == start) {
+            current->end_index = end;
+        } else {
+            if (current) pango_attr_list_insert(attrs, current);
+            current = pango_attr_weight_new(PANGO_WEIGHT_BOLD);
+            current->start_index = start;
+            current->end_index = end;
+        }
+    }
+    if (current) pango_attr_list_insert(attrs, current);
+
+    gtk_label_set_attributes(label, attrs);
+    pango_attr_list_unref(attrs);
+}
+
+static void add_slot(ResultView *view) {
+    GtkWidget *row = gtk_list_box_row_new();
+    gtk_style_context_add_class(gtk_widget_get_style_context(row), "app-row");
+
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_style_context_add_class(gtk_widget_get_style_context(box), "app-row-box");
+
+    GtkWidget *icon = gtk_image_new();
+    gtk_style_context_add_class(gtk_widget_get_style_context(icon), "app-icon");
+    if (view->icons) {
+        gint width, height;
+        gtk_icon_size_lookup(GTK_ICON_SIZE_DIALOG, &width, &height);
+        gtk_widget_set_size_request(icon, width, height);
+    }
+
+    GtkWidget *label = gtk_label_new(NULL);
+    gtk_label_set_xalign(GTK_LABEL(label), 0);
+    gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+    gtk_style_context_add_class(gtk_widget_get_style_context(label), "app-name");
+
+    gtk_box_pack_start(GTK_BOX(box), icon, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(box), label, TRUE, TRUE, 0);
+    gtk_container_add(GTK_CONTAINER(row), box);
+    gtk_widget_show_all(box);
+    // Row visibility belongs to bind_slot(), not to the window's show_all.
+    gtk_widget_set_no_show_all(row, TRUE);
+
+    g_object_set_data(G_OBJECT(row), "app-icon", icon);
+    g_object_set_data(G_OBJECT(row), "app-label", label);
+    g_object_set_data(G_OBJECT(row), "slot-index", GUINT_TO_POINTER(view->slots->len));
+    g_ptr_array_add(view->slots, row);
+    gtk_list_box_insert(view->list_box, row, -1);
+}
+
+// Shows the app's icon if the loader has it, or leaves the reserved space empty
+// as a placeholder until result_view_icons_ready() comes back to the row.
+static void bind_icon(ResultView *view, GtkWidget *row, AppInfo *app) {
+    GtkImage *icon = g_object_get_data(G_OBJECT(row), "app-icon");
+    GdkPixbuf *pixbuf = NULL;
+    if (view->icons && app->icon) {
+        pixbuf = icon_loader_lookup(view->icons, app->icon);
+    }
+    if (pixbuf) {
+        gtk_image_set_from_pixbuf(icon, pixbuf);
+    } else {
+        gtk_image_clear(icon);
+    }
+    g_object_set_data(G_OBJECT(row), "icon-pending", GINT_TO_POINTER(!pixbuf && view->icons && app->icon));
+}
+
+// Points a slot at the item offset + slot_index, or hides it past the end.
+static void bind_slot(ResultView *view, guint slot_index) {
+    GtkWidget *row = g_ptr_array_index(view->slots, slot_index);
+    guint item = view->offset + slot_index;
+    if (item >= n_items(view)) {
+        gtk_widget_hide(row);
+        g_object_set_data(G_OBJECT(row), "app-info", NULL);
+        return;
+    }
+
+    AppInfo *app = g_ptr_array_index(view->apps, g_array_index(view->items, guint32, item));
+    GtkLabel *label = g_object_get_data(G_OBJECT(row), "app-label");
+
+    // Positions are offsets into the key; they only apply to the name if the two line up.
+    guint positions[FUZZY_MAX_QUERY];
+    gsize n_positions = 0;
+    gint score;
+    if (view->query.len > 0 && app->key_aligned &&
+        fuzzy_match(&view->query, app->key, app->name, app->char_mask, &score, positions)) {
+        n_positions = view->query.len;
+    }
+
+    if (g_object_get_data(G_OBJECT(row), "app-info") != app) {
+        gtk_label_set_text(label, app->name);
+        g_object_set_data(G_OBJECT(row), "app-info", app);
+        bind_icon(view, row, app);
+    }
+    set_match_highlight(label, app->name, positions, n_positions);
+    gtk_widget_show(row);
+}
+
+static void sync_selection(ResultView *view) {
+    gint slot_index = view->selected - (gint)view->offset;
+    if (view->selected >= 0 && slot_index >= 0 && slot_index < (gint)view->slots->len) {
+        gtk_list_box_select_row(view->list_box, g_ptr_array_index(view->slots, slot_index));
+    } else {
+        gtk_list_box_unselect_all(view->list_box);
+    }
+}
+
+static void refresh(ResultView *view) {
+    for (guint i = 0; i < view->slots->len; i++) {
+        bind_slot(view, i);
+    }
+    sync_selection(view);
+}
+
+void result_view_icons_ready(ResultView *view) {
+    for (guint i = 0; i < view->slots->len; i++) {
+        GtkWidget *row = g_ptr_array_index(view->slots, i);
+        AppInfo *app = g_object_get_data(G_OBJECT(row), "app-info");
+        if (app && g_object_get_data(G_OBJECT(row), "icon-pending")) {
+            bind_icon(view, row, app);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Scrolling
+// -----------------------------------------------------------------------------
+
+static guint max_offset(ResultView *view) {
+    guint page = MAX(view->n_visible, 1);
+    return n_items(view) > page ? n_items(view) - page : 0;
+}
+
+static void update_adjustment(ResultView *view) {
+    guint page = MAX(view->n_visible, 1);
+    view->updating = TRUE;
+    gtk_adjustment_configure(view->adjustment, view->offset, 0, n_items(view), 1, page, page);
+    view->updating = FALSE;
+    gtk_widget_set_visible(view->scrollbar, n_items(view) > page);
+}
+
+// Scrolls so that offset is the first item shown. Returns TRUE if it moved.
+static gboolean set_offset(ResultView *view, guint offset) {
+    offset = MIN(offset, max_offset(view));
+    if (offset == view->offset) return FALSE;
+    view->offset = offset;
+    view->updating = TRUE;
+    gtk_adjustment_set_value(view->adjustment, offset);
+    view->updating = FALSE;
+    refresh(view);
+    return TRUE;
+}
+
+static guint offset_showing_selection(ResultView *view) {
+    guint page = MAX(view->n_visible, 1);
+    if (view->selected < 0) return view->offset;
+    guint selected = view->selected;
+    if (selected < view->offset) return selected;
+    if (selected >= view->offset + page) return selected - page + 1;
+    return view->offset;
+}
+
+static void on_adjustment_value_changed(GtkAdjustment *adjustment, gpointer user_data) {
+    ResultView *view = user_data;
+    if (view->updating) return;
+    set_offset(view, (guint)(gtk_adjustment_get_value(adjustment) + 0.5));
+}
+
+static gboolean on_scroll_event(GtkWidget *widget, GdkEventScroll *event, gpointer user_data) {
+    ResultView *view = user_data;
+    gdouble delta = 0;
+    switch (event->direction) {
+        case GDK_SCROLL_UP:
+            delta = -WHEEL_STEP;
+            break;
+        case GDK_SCROLL_DOWN:
+            delta = WHEEL_STEP;
+            break;
+        case GDK_SCROLL_SMOOTH:
+            view->scroll_delta += event->delta_y * WHEEL_STEP;
+            delta = (gint)view->scroll_delta;
+            view->scroll_delta -= delta;
+            break;
+        default:
+            return FALSE;
+    }
+
+    gint offset = (gint)view->offset + (gint)delta;
+    set_offset(view, MAX(offset, 0));
+    return TRUE;
+}
+
+// Creates as many rows as fit in the viewport. Runs from an idle callback, since
+// adding rows from inside a size allocation would queue another one.
+static gboolean relayout(gpointer user_data) {
+    ResultView *view = user_data;
+    view->layout_source = 0;
+
+    gint row_height;
+    gtk_widget_get_preferred_height(g_ptr_array_index(view->slots, 0), NULL, &row_height);
+    view->n_visible = MAX(view->viewport_height / MAX(row_height, 1), 1);
+
+    // One extra row shows the partially visible item at the bottom.
+    guint wanted = MIN(view->n_visible + 1, MAX_SLOTS);
+    while (view->slots->len < wanted) {
+        add_slot(view);
+    }
+
+    view->offset = MIN(offset_showing_selection(view), max_offset(view));
+    update_adjustment(view);
+    refresh(view);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_viewport_size_allocate(GtkWidget *widget, GdkRectangle *allocation, gpointer user_data) {
+    ResultView *view = user_data;
+    if (allocation->height == view->viewport_height) return;
+    view->viewport_height = allocation->height;
+    if (!view->layout_source) {
+        view->layout_source = g_idle_add(relayout, view);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Selection
+// -----------------------------------------------------------------------------
+
+static void on_row_activated(GtkListBox *box, GtkListBoxRow *row, gpointer user_data) {
+    ResultView *view = user_data;
+    guint slot_index = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(row), "slot-index"));
+    if (view->offset + slot_index >= n_items(view)) return;
+    view->selected = view->offset + slot_index;
+    view->activate(view->user_data);
+}
+
+// Keeps the selected item in step with rows selected by clicking.
+static void on_row_selected(GtkListBox *box, GtkListBoxRow *row, gpointer user_data) {
+    ResultView *view = user_data;
+    if (!row) return;
+    guint slot_index = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(row), "slot-index"));
+    if (view->offset + slot_index < n_items(view)) {
+        view->selected = view->offset + slot_index;
+    }
+}
+
+void result_view_move_selection(ResultView *view, gint delta) {
+    gint n = n_items(view);
+    if (n == 0) return;
+    result_view_select(view, ((view->selected + delta) % n + n) % n);
+}
+
+void result_view_select(ResultView *view, gint item) {
+    gint n = n_items(view);
+    if (n == 0) return;
+    view->selected = CLAMP(item, 0, n - 1);
+    if (!set_offset(view, offset_showing_selection(view))) {
+        sync_selection(view);
+    }
+}
+
+gint result_view_get_selected_index(ResultView *view) {
+    return view->selected;
+}
+
+guint result_view_get_page_size(ResultView *view) {
+    return MAX(view->n_visible, 1);
+}
+
+AppInfo* result_view_get_selected(ResultView *view) {
+    if (view->selected < 0 || (guint)view->selected >= n_items(view)) return NULL;
+    return g_ptr_array_index(view->apps, g_array_index(view->items, guint32, view->selected));
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+ResultView* result_view_new(IconLoader *icons, ResultViewActivateFunc activate, gpointer user_data) {
+    ResultView *view = g_new0(ResultView, 1);
+    view->icons = icons;
+    view->activate = activate;
+    view->user_data = user_data;
+    view->slots = g_ptr_array_new();
+    view->items = g_array_new(FALSE, FALSE, sizeof(guint32));
+    view->selected = -1;
+    view->viewport_height = -1;
+
+    view->widget = g_object_ref_sink(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0));
+
+    // The rows never need scrolling by the scrolled window itself; it only
+    // lets the list be shorter than its rows and clips the partial last one.
+    view->scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_widget_set_app_paintable(view->scrolled, TRUE);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(view->scrolled), GTK_POLICY_NEVER, GTK_POLICY_EXTERNAL);
+    gtk_style_context_add_class(gtk_widget_get_style_context(view->scrolled), "scrolled-window");
+    gtk_box_pack_start(GTK_BOX(view->widget), view->scrolled, TRUE, TRUE, 0);
+
+    view->event_box = gtk_event_box_new();
+    gtk_event_box_set_visible_window(GTK_EVENT_BOX(view->event_box), FALSE);
+    gtk_widget_add_events(view->event_box, GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+    gtk_container_add(GTK_CONTAINER(view->scrolled), view->event_box);
+
+    view->list_box = GTK_LIST_BOX(gtk_list_box_new());
+    gtk_style_context_add_class(gtk_widget_get_style_context(GTK_WIDGET(view->list_box)), "app-list");
+    gtk_list_box_set_selection_mode(view->list_box, GTK_SELECTION_SINGLE);
+    gtk_container_add(GTK_CONTAINER(view->event_box), GTK_WIDGET(view->list_box));
+
+    view->adjustment = GTK_ADJUSTMENT(g_object_ref_sink(gtk_adjustment_new(0, 0, 0, 1, 1, 1)));
+    view->scrollbar = gtk_scrollbar_new(GTK_ORIENTATION_VERTICAL, view->adjustment);
+    gtk_widget_set_no_show_all(view->scrollbar, TRUE);
+    gtk_box_pack_start(GTK_BOX(view->widget), view->scrollbar, FALSE, FALSE, 0);
+
+    // The first row is what the row height gets measured on.
+    add_slot(view);
+    gtk_widget_hide(g_ptr_array_index(view->slots, 0));
+
+    g_signal_connect(view->scrolled, "size-allocate", G_CALLBACK(on_viewport_size_allocate), view);
+    g_signal_connect(view->event_box, "scroll-event", G_CALLBACK(on_scroll_event), view);
+    g_signal_connect(view->adjustment, "value-changed", G_CALLBACK(on_adjustment_value_changed), view);
+    g_signal_connect(view->list_box, "row-activated", G_CALLBACK(on_row_activated), view);
+    g_signal_connect(view->list_box, "row-selected", G_CALLBACK(on_row_selected), view);
+    return view;
+}
+
+GtkWidget* result_view_get_widget(ResultView *view) {
+    return view->widget;
+}
+
+void result_view_set_apps(ResultView *view, GPtrArray *apps) {
+    view->apps = apps;
+    for (guint i = 0; i < view->slots->len; i++) {
+        g_object_set_data(G_OBJECT(g_ptr_array_index(view->slots, i)), "app-info", NULL);
+    }
+    g_array_set_size(view->items, 0);
+    view->query.len = 0;
+    view->offset = 0;
+    view->selected = -1;
+    update_adjustment(view);
+    refresh(view);
+}
+
+void result_view_set_items(ResultView *view, const guint32 *ids, guint n_ids, const FuzzyQuery *query,
+                           guint generation) {
+    // More of the same query's answer arrived: follow the selected entry to
+    // wherever it moved and keep it on the same row.
+    gint selected = -1;
+    gint offset = 0;
+    if (generation == view->generation && view->selected >= 0) {
+        guint32 id = g_array_index(view->items, guint32, view->selected);
+        for (guint i = 0; i < n_ids; i++) {
+            if (ids[i] == id) {
+                selected = i;
+                offset = MAX(selected - (view->selected - (gint)view->offset), 0);
+                break;
+            }
+        }
+    }
+    view->generation = generation;
+
+    g_array_set_size(view->items, n_ids);
+    if (n_ids > 0) {
+        memcpy(view->items->data, ids, n_ids * sizeof(guint32));
+    }
+    if (query) {
+        view->query = *query;
+    } else {
+        view->query.len = 0;
+    }
+    if (selected >= 0) {
+        view->selected = selected;
+        view->offset = MIN((guint)offset, max_offset(view));
+    } else {
+        view->selected = n_ids > 0 ? 0 : -1;
+        view->offset = 0;
+    }
+    update_adjustment(view);
+    refresh(view);
+}
+
+void result_view_free(ResultView *view) {
+    if (!view) return;
+    if (view->layout_source) g_source_remove(view->layout_source);
+    g_signal_handlers_disconnect_by_data(view->scrolled, view);
+    g_signal_handlers_disconnect_by_data(view->event_box, view);
+    g_signal_handlers_disconnect_by_data(view->adjustment, view);
+    g_signal_handlers_disconnect_by_data(view->list_box, view);
+    g_object_unref(view->adjustment);
+    g_object_unref(view->widget);
+    g_ptr_array_unref(view->slots);
+    g_array_unref(view->items);
+    g_free(view);
+}
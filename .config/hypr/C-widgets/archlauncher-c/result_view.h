@@ -0,0 +1,62 @@
+#ifndef RESULT_VIEW_H
+#define RESULT_VIEW_H
+
+#include <gtk/gtk.h>
+#include "app_info.h"
+#include "fuzzy.h"
+#include "icon_loader.h"
+
+// A virtualized result list. Only as many rows as fit on screen exist as
+// widgets; scrolling and searching rebind those rows to different entries of
+// an array of item ids instead of creating, hiding or sorting widgets.
+typedef struct _ResultView ResultView;
+
+// Called when an item is activated with the mouse. The activated item is the
+// selection by the time the callback runs.
+typedef void (*ResultViewActivateFunc)(gpointer user_data);
+
+// Rows take their icons from icons, or have none if it is NULL. With icons
+// every row reserves room for a dialog-sized icon, so all rows have the same
+// height whether or not the entry's icon has loaded yet.
+ResultView* result_view_new(IconLoader *icons, ResultViewActivateFunc activate, gpointer user_data);
+
+// Rebinds the rows on screen still waiting for their icon. Call it from the
+// IconLoader's ready callback.
+void result_view_icons_ready(ResultView *view);
+
+// The top-level widget to pack into the window
+GtkWidget* result_view_get_widget(ResultView *view);
+
+// Sets the array of AppInfo that item ids point into and shows nothing until
+// result_view_set_items(). apps must stay alive until the view is freed; it
+// may grow meanwhile, but its existing entries must not change.
+void result_view_set_apps(ResultView *view, GPtrArray *apps);
+
+// Shows the n_ids entries of ids (positions in apps) in the given order.
+// Matched characters are highlighted against query. generation identifies the
+// query the items answer: for a new one the first item is selected, while
+// within the same one the selected entry stays selected and in its place on
+// screen as long as it is still among ids.
+void result_view_set_items(ResultView *view, const guint32 *ids, guint n_ids, const FuzzyQuery *query,
+                           guint generation);
+
+// Moves the selection by delta items, wrapping around at either end, and
+// scrolls it into view.
+void result_view_move_selection(ResultView *view, gint delta);
+
+// Selects item (a position in the shown order), clamped to the first and last
+// item, and scrolls it into view.
+void result_view_select(ResultView *view, gint item);
+
+// The selected position in the shown order, -1 if nothing is shown.
+gint result_view_get_selected_index(ResultView *view);
+
+// How many items fit on screen at once, for paging.
+guint result_view_get_page_size(ResultView *view);
+
+// Returns the selected AppInfo, or NULL if nothing is shown.
+AppInfo* result_view_get_selected(ResultView *view);
+
+void result_view_free(ResultView *view);
+
+#endif // RESULT_VIEW_H
@@ -0,0 +1,258 @@
+#include "run_cache.h"
+#include "app_info.h"
+#include "path_scanner.h"
+#include <glib/gstdio.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Cache Format
+// -----------------------------------------------------------------------------
+//
+// # cachy run cache v2
+// path /usr/local/bin:/usr/bin
+// dir <mtime_sec> <mtime_nsec> /usr/local/bin
+// \t<executable>
+// \t<executable>
+// dir <mtime_sec> <mtime_nsec> /usr/bin
+// ...
+//
+// Executables are listed per directory (not merged), so a single changed
+// directory can be rescanned and merged back in $PATH order.
+
+#define RUN_CACHE_HEADER "# cachy run cache v2"
+
+// The executables of one $PATH directory and the mtime they were read at
+typedef struct {
+    gint64 mtime_sec;
+    gint64 mtime_nsec;
+    GPtrArray *names;
+} DirEntries;
+
+static DirEntries* dir_entries_new(gint64 mtime_sec, gint64 mtime_nsec) {
+    DirEntries *entries = g_new(DirEntries, 1);
+    entries->mtime_sec = mtime_sec;
+    entries->mtime_nsec = mtime_nsec;
+    entries->names = g_ptr_array_new_with_free_func(g_free);
+    return entries;
+}
+
+static void dir_entries_free(gpointer data) {
+    DirEntries *entries = data;
+    g_ptr_array_unref(entries->names);
+    g_free(entries);
+}
+
+static void stat_mtime(const gchar *path, gint64 *sec, gint64 *nsec) {
+    GStatBuf st;
+    if (g_stat(path, &st) == 0) {
+        *sec = st.st_mtim.tv_sec;
+        *nsec = st.st_mtim.tv_nsec;
+    } else {
+        *sec = 0;
+        *nsec = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Reading and Writing the Cache
+// -----------------------------------------------------------------------------
+
+// Parses the cache file into dir path -> DirEntries. Returns the $PATH string the
+// cache was written for, or NULL if there is no usable cache.
+static gchar* read_cache(const gchar *cache_path, GHashTable *dirs) {
+    gchar *contents;
+    gsize length;
+    if (!g_file_get_contents(cache_path, &contents, &length, NULL)) {
+        return NULL;
+    }
+
+    gchar *path_env = NULL;
+    DirEntries *current = NULL;
+    gboolean header_ok = FALSE;
+    gchar *line = contents;
+    gchar *end = contents + length;
+
+    while (line < end) {
+        gchar *newline = memchr(line, '\n', end - line);
+        if (newline) *newline = '\0';
+        gchar *next = newline ? newline + 1 : end;
+
+        if (!header_ok) {
+            // Anything else (e.g. the old flat list of names) is treated as no cache.
+            if (g_strcmp0(line, RUN_CACHE_HEADER) != 0) break;
+            header_ok = TRUE;
+        } else if (line[0] == '\t') {
+            if (current && line[1] != '\0') {
+                g_ptr_array_add(current->names, g_strdup(line + 1));
+            }
+        } else if (g_str_has_prefix(line, "path ")) {
+            g_free(path_env);
+            path_env = g_strdup(line + 5);
+        } else if (g_str_has_prefix(line, "dir ")) {
+            gchar *cursor = line + 4;
+            gint64 sec = g_ascii_strtoll(cursor, &cursor, 10);
+            gint64 nsec = g_ascii_strtoll(cursor, &cursor, 10);
+            current = NULL;
+            if (*cursor == ' ' && cursor[1] != '\0') {
+                current = dir_entries_new(sec, nsec);
+                g_hash_table_replace(dirs, g_strdup(cursor + 1), current);
+            }
+        }
+        line = next;
+    }
+
+    g_free(contents);
+    if (!header_ok) {
+        g_free(path_env);
+        return NULL;
+    }
+    return path_env ? path_env : g_strdup("");
+}
+
+static void write_cache(const gchar *cache_path, const gchar *path_env, GPtrArray *dir_paths, GHashTable *dirs) {
+    GString *content = g_string_new(RUN_CACHE_HEADER "\n");
+    g_string_append_printf(content, "path %s\n", path_env);
+
+    for (guint i = 0; i < dir_paths->len; i++) {
+        const gchar *dir_path = g_ptr_array_index(dir_paths, i);
+        DirEntries *entries = g_hash_table_lookup(dirs, dir_path);
+        g_string_append_printf(content, "dir %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s\n",
+                               entries->mtime_sec, entries->mtime_nsec, dir_path);
+        for (guint j = 0; j < entries->names->len; j++) {
+            g_string_append_c(content, '\t');
+            g_string_append(content, g_ptr_array_index(entries->names, j));
+            g_string_append_c(content, '\n');
+        }
+    }
+
+    GError *error = NULL;
+    if (!g_file_set_contents(cache_path, content->str, content->len, &error)) {
+        g_warning("Failed to write RUN cache: %s", error->message);
+        g_error_free(error);
+    }
+    g_string_free(content, TRUE);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+gboolean run_cache_is_stale(void) {
+    const gchar *path_env = g_getenv("PATH");
+    if (!path_env) {
+        return FALSE;
+    }
+
+    gchar *cache_path = launcher_cache_path(RUN_CACHE_FILE);
+    GHashTable *cached = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dir_entries_free);
+    gchar *cached_path_env = read_cache(cache_path, cached);
+    gboolean stale = g_strcmp0(cached_path_env, path_env) != 0;
+
+    gchar **paths = g_strsplit(path_env, ":", 0);
+    for (int i = 0; !stale && paths[i] != NULL; i++) {
+        if (paths[i][0] == '\0') continue;
+        DirEntries *entries = g_hash_table_lookup(cached, paths[i]);
+        gint64 sec, nsec;
+        stat_mtime(paths[i], &sec, &nsec);
+        stale = !entries || entries->mtime_sec != sec || entries->mtime_nsec != nsec;
+    }
+
+    g_strfreev(paths);
+    g_free(cached_path_env);
+    g_hash_table_destroy(cached);
+    g_free(cache_path);
+    return stale;
+}
+
+GPtrArray* run_cache_load(gboolean force_rebuild) {
+    const gchar *path_env = g_getenv("PATH");
+    if (!path_env) {
+        return NULL;
+    }
+
+    gchar *cache_path = launcher_cache_path(RUN_CACHE_FILE);
+    GHashTable *cached = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dir_entries_free);
+    gchar *cached_path_env = force_rebuild ? NULL : read_cache(cache_path, cached);
+
+    // A different $PATH still reuses every directory it shares with the cached
+    // one; it only forces the cache file to be rewritten.
+    gboolean dirty = g_strcmp0(cached_path_env, path_env) != 0;
+    g_free(cached_path_env);
+
+    gchar **paths = g_strsplit(path_env, ":", 0);
+    GPtrArray *dir_paths = g_ptr_array_new();
+    GHashTable *dirs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, dir_entries_free);
+    GPtrArray *stale_paths = g_ptr_array_new();
+    GPtrArray *stale_entries = g_ptr_array_new();
+
+    for (int i = 0; paths[i] != NULL; i++) {
+        if (paths[i][0] == '\0' || g_hash_table_contains(dirs, paths[i])) {
+            continue;
+        }
+
+        gint64 sec, nsec;
+        stat_mtime(paths[i], &sec, &nsec);
+
+        gpointer key = NULL;
+        gpointer value = NULL;
+        DirEntries *entries = NULL;
+        if (g_hash_table_steal_extended(cached, paths[i], &key, &value)) {
+            g_free(key);
+            entries = value;
+            if (entries->mtime_sec != sec || entries->mtime_nsec != nsec) {
+                dir_entries_free(entries);
+                entries = NULL;
+            }
+        }
+        gchar *dir_path = g_strdup(paths[i]);
+        if (!entries) {
+            g_debug("Rescanning RUN directory: %s", dir_path);
+            entries = dir_entries_new(sec, nsec);
+            g_ptr_array_add(stale_paths, dir_path);
+            g_ptr_array_add(stale_entries, entries);
+            dirty = TRUE;
+        }
+        g_hash_table_insert(dirs, dir_path, entries);
+        g_ptr_array_add(dir_paths, dir_path);
+    }
+
+    // Rescan all stale directories in one go so they are read concurrently.
+    if (stale_paths->len > 0) {
+        GPtrArray *scanned = path_scanner_scan((const gchar * const *)stale_paths->pdata, stale_paths->len);
+        for (guint i = 0; i < scanned->len; i++) {
+            DirEntries *entries = g_ptr_array_index(stale_entries, i);
+            g_ptr_array_unref(entries->names);
+            entries->names = g_ptr_array_ref(g_ptr_array_index(scanned, i));
+        }
+        g_ptr_array_unref(scanned);
+    }
+
+    // Merge the directories in $PATH order, first occurrence wins.
+    GPtrArray *executables = g_ptr_array_new_with_free_func(g_free);
+    GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < dir_paths->len; i++) {
+        const gchar *dir_path = g_ptr_array_index(dir_paths, i);
+        DirEntries *entries = g_hash_table_lookup(dirs, dir_path);
+        for (guint j = 0; j < entries->names->len; j++) {
+            gchar *name = g_ptr_array_index(entries->names, j);
+            if (g_hash_table_add(seen, name)) {
+                g_ptr_array_add(executables, g_build_filename(dir_path, name, NULL));
+            }
+        }
+    }
+
+    if (dirty) {
+        g_debug("Writing RUN cache to: %s", cache_path);
+        write_cache(cache_path, path_env, dir_paths, dirs);
+    }
+
+    g_hash_table_destroy(seen);
+    g_hash_table_destroy(dirs);
+    g_hash_table_destroy(cached);
+    g_ptr_array_unref(stale_entries);
+    g_ptr_array_unref(stale_paths);
+    g_ptr_array_unref(dir_paths);
+    g_strfreev(paths);
+    g_free(cache_path);
+    return executables;
+}
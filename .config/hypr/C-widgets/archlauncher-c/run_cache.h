@@ -0,0 +1,20 @@
+#ifndef RUN_CACHE_H
+#define RUN_CACHE_H
+
+#include <glib.h>
+
+// Name of the PATH executable cache inside ~/.cache/cachy/
+#define RUN_CACHE_FILE "run_cache.txt"
+
+// Returns the absolute paths of the executables found in $PATH, one per name,
+// first occurrence wins. The cache remembers the mtime of every $PATH
+// directory, so only directories that changed since the last run are
+// rescanned; force_rebuild rescans all of them. Returns NULL if $PATH is unset.
+// Free with g_ptr_array_unref().
+GPtrArray* run_cache_load(gboolean force_rebuild);
+
+// TRUE if $PATH changed since the cache was written or one of its directories
+// did, i.e. if run_cache_load() would rescan anything. Only stats the directories.
+gboolean run_cache_is_stale(void);
+
+#endif // RUN_CACHE_H
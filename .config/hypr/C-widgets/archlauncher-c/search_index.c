@@ -0,0 +1,95 @@
+#include "search_index.h"
+#include "app_info.h"
+#include <string.h>
+
+// A byte found in more than 1/MAX_POSTING_SHARE of the keys gets no posting list
+#define MAX_POSTING_SHARE 8
+
+// Posting lists for every indexed byte value, stored back to back: the ids of
+// the keys containing byte b are ids[offsets[b] .. offsets[b + 1]).
+struct _SearchIndex {
+    guint n_apps;
+    guint64 indexed[4];   // Bit b is set if byte b has a posting list
+    guint32 offsets[257];
+    guint32 *ids;
+};
+
+// Runs body once for every distinct byte b of key.
+#define FOR_EACH_DISTINCT_BYTE(key, b, body)                           \
+    do {                                                               \
+        guint64 seen_[4] = { 0, 0, 0, 0 };                             \
+        for (const guchar *p_ = (const guchar *)(key); *p_; p_++) {    \
+            guchar b = *p_;                                            \
+            guint64 bit_ = G_GUINT64_CONSTANT(1) << (b & 63);          \
+            if (seen_[b >> 6] & bit_) continue;                        \
+            seen_[b >> 6] |= bit_;                                     \
+            body                                                       \
+        }                                                              \
+    } while (0)
+
+static gboolean is_indexed(const SearchIndex *index, guchar b) {
+    return (index->indexed[b >> 6] >> (b & 63)) & 1;
+}
+
+SearchIndex* search_index_new(GPtrArray *apps) {
+    SearchIndex *index = g_new0(SearchIndex, 1);
+    guint32 counts[256] = { 0 };
+    index->n_apps = apps->len;
+
+    // Pass 1: size every posting list, and leave out the common bytes.
+    for (guint i = 0; i < apps->len; i++) {
+        AppInfo *app = g_ptr_array_index(apps, i);
+        FOR_EACH_DISTINCT_BYTE(app->key, b, { counts[b]++; });
+    }
+    for (guint b = 0; b < 256; b++) {
+        if (counts[b] > index->n_apps / MAX_POSTING_SHARE) {
+            counts[b] = 0;
+        } else {
+            index->indexed[b >> 6] |= G_GUINT64_CONSTANT(1) << (b & 63);
+        }
+        index->offsets[b + 1] = index->offsets[b] + counts[b];
+    }
+
+    // Pass 2: fill them. Walking the array in order keeps every list sorted.
+    index->ids = g_new(guint32, MAX(index->offsets[256], 1));
+    guint32 fill[256];
+    memcpy(fill, index->offsets, sizeof(fill));
+    for (guint32 id = 0; id < apps->len; id++) {
+        AppInfo *app = g_ptr_array_index(apps, id);
+        FOR_EACH_DISTINCT_BYTE(app->key, b, {
+            if (is_indexed(index, b)) index->ids[fill[b]++] = id;
+        });
+    }
+    return index;
+}
+
+void search_index_free(SearchIndex *index) {
+    if (!index) return;
+    g_free(index->ids);
+    g_free(index);
+}
+
+const guint32* search_index_candidates(SearchIndex *index, const gchar *query, guint *n_candidates) {
+    if (query[0] == '\0') {
+        *n_candidates = index->n_apps;
+        return NULL;
+    }
+
+    // Every byte of the query has to occur in a matching key, so the shortest
+    // posting list among the query's bytes is a complete candidate set. The
+    // remaining bytes are checked cheaply by the matcher's mask prefilter.
+    gint best_byte = -1;
+    for (const guchar *p = (const guchar *)query; *p; p++) {
+        if (!is_indexed(index, *p)) continue;
+        guint len = index->offsets[*p + 1] - index->offsets[*p];
+        if (best_byte < 0 || len < index->offsets[best_byte + 1] - index->offsets[best_byte]) {
+            best_byte = *p;
+        }
+    }
+    if (best_byte < 0) {
+        *n_candidates = index->n_apps;
+        return NULL;
+    }
+    *n_candidates = index->offsets[best_byte + 1] - index->offsets[best_byte];
+    return index->ids + index->offsets[best_byte];
+}
@@ -0,0 +1,25 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <glib.h>
+
+// An inverted index over the search keys of an array of AppInfo, so a query
+// only has to visit the entries that can possibly match it. Entries are
+// identified by their position in the array. Bytes found in a large share of
+// the keys are not indexed: their lists would cost the most memory and never
+// narrow a query down much.
+typedef struct _SearchIndex SearchIndex;
+
+// Builds the index over the keys of an array of AppInfo.
+SearchIndex* search_index_new(GPtrArray *apps);
+
+void search_index_free(SearchIndex *index);
+
+// Returns the ascending ids of the entries whose key contains every byte of the
+// (folded) query, or a superset of them, and stores their count in n_candidates.
+// The array belongs to the index. Returns NULL for an empty query or one made
+// of unindexed bytes only, meaning that every entry (n_candidates of them) is
+// a candidate.
+const guint32* search_index_candidates(SearchIndex *index, const gchar *query, guint *n_candidates);
+
+#endif // SEARCH_INDEX_H
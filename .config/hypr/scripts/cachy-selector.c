@@ -1,10 +1,19 @@
 #include <gtk/gtk.h>
 #include <gtk-layer-shell/gtk-layer-shell.h>
 #include <gio/gio.h>
+#include <gio/gunixinputstream.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <gif_lib.h>
+#include <math.h>
+#include <setjmp.h>
 #include <stdio.h>
+#include <jpeglib.h> // Needs FILE from stdio.h
 #include <string.h>
+#include <unistd.h>
+#include <webp/decode.h>
 
 // --- Configuration Constants ---
 
@@ -15,15 +24,91 @@ static const int PREVIEW_WIDTH = 220;
 static const int PREVIEW_HEIGHT = 124;
 static const int PREVIEW_SPACING = 20;
 
+// Only the previews on screen, plus PREVIEW_MARGIN_SLOTS either side, exist as
+// widgets; they are rebound to other wallpapers as the strip scrolls. Decoded
+// previews are kept for the PREVIEW_CACHE_SIZE wallpapers nearest the view.
+static const int PREVIEW_MARGIN_SLOTS = 2;
+static const int PREVIEW_CACHE_SIZE = 64;
+
+// Moving the selection scrolls the strip over SCROLL_DURATION_US, unless the
+// new selection is more than a strip's width away (after wrapping around).
+static const gint64 SCROLL_DURATION_US = 180 * 1000;
+
+// Thumbnails follow the freedesktop.org thumbnail spec, so they are shared
+// with file managers: ~/.cache/thumbnails/large/<md5 of the file URI>.png,
+// at most 256px on either side.
+static const int THUMB_SIZE = 256;
+static const char *THUMB_FLAVOR = "large";
+static const char *THUMB_FAIL_DIR = "cachy-selector";
+
+// Thumbnails are decoded on a pool of their own, nearest to the middle of the
+// view first. Only previews within DECODE_WINDOW of it are queued; the others
+// wait until the view comes closer.
+static const int DECODE_MAX_THREADS = 4;
+static const int DECODE_WINDOW = 8;
+
+// Paths are read from stdin as they arrive and turned into previews at most
+// INGEST_BATCH_SIZE per frame, so the window shows while the list streams in.
+static const gsize INGEST_READ_SIZE = 64 * 1024;
+static const int INGEST_BATCH_SIZE = 32;
+
 
 // --- Application Data Structure ---
 
+typedef enum {
+    DECODE_IDLE,    // Not decoded (or dropped from the preview cache), and not queued either
+    DECODE_QUEUED,
+    DECODE_DONE
+} DecodeState;
+
+/** @brief One wallpaper read from stdin. */
+typedef struct {
+    char *path;
+    const char *name;   // The file name part of path
+    int index;
+    gint state;         // DecodeState, accessed atomically
+} WallpaperItem;
+
+/** @brief A preview widget, showing whichever wallpaper it is bound to. */
+typedef struct {
+    GtkWidget *event_box;
+    GtkImage *image;
+    GtkLabel *label;
+    int index;          // Of the wallpaper shown, -1 before the first one
+    gboolean placed;    // Shown by the last strip_layout()
+} PreviewSlot;
+
 typedef struct {
     GtkWindow *window;
-    GtkBox *hbox;
-    GtkScrolledWindow *scrolled_window;
-    GList *previews;
+
+    /** @brief The virtualized strip: a few slots, moved to scroll. */
+    GtkFixed *strip;
+    GtkBorder strip_padding;    // From the CSS of #main-hbox
+    PreviewSlot *slots;
+    int n_slots;
+    int slot_width;             // Of a preview with the CSS applied
+    double scroll_offset;       // Of the strip's content, in pixels
+    double scroll_from;         // Where the running scroll animation started...
+    double scroll_target;       // ...and where it ends
+    gint64 scroll_start_time;   // Frame time it started at
+    guint scroll_tick_id;       // Its tick callback, 0 when none runs
+    cairo_surface_t *placeholder;
+    GHashTable *preview_cache;  // Index -> cairo_surface_t of a decoded preview
+
+    GPtrArray *items;           // WallpaperItem, by index
     int selected_index;
+    int n_items;                // Written atomically, read by the decode pool
+    int decode_focus;           // Item in the middle of the view, likewise
+
+    /** @brief Decodes thumbnails, ordered by distance from decode_focus. */
+    GThreadPool *decode_pool;
+
+    /** @brief Streams the paths in from stdin. */
+    GInputStream *stdin_stream;
+    GString *stdin_partial;    // The start of a line whose newline hasn't come yet
+    GThreadPool *ingest_pool;  // Checks the paths exist; one thread, so they stay in order
+    GAsyncQueue *ingest_queue; // Paths checked and waiting for a preview, "" once stdin is done
+    guint ingest_tick_id;      // Adds the waiting previews, while there are any
 
     /** @brief A master cancellation token for all async operations. */
     GCancellable *cancellable;
@@ -32,89 +117,187 @@ typedef struct {
 
 
 // --- Forward Declarations ---
-static void app_update_view(Application *app);
-static GtkWidget* ui_create_wallpaper_preview(Application *app, const char* path_str, int index);
+static void decode_schedule(Application *app);
+static gboolean on_ingest_ready(gpointer user_data);
 
 
-// --- Core Logic & Event Handlers ---
+// --- Preview Strip ---
 
-static void app_select_and_quit(GtkWidget *preview_widget) {
-    const char* path = g_object_get_data(G_OBJECT(preview_widget), "wallpaper-path");
-    if (path) {
-        g_print("%s\n", path);
-        fflush(stdout);
+// Distance between the left edges of two neighbouring previews.
+static int strip_step(Application *app) {
+    return app->slot_width + PREVIEW_SPACING;
+}
+
+// Width of all previews side by side, with the strip's padding.
+static double strip_content_width(Application *app) {
+    int count = app->items->len;
+    return app->strip_padding.left + app->strip_padding.right + MAX(count * strip_step(app) - PREVIEW_SPACING, 0);
+}
+
+// Left edge of preview index, relative to the visible part of the strip.
+static double strip_item_x(Application *app, int index) {
+    // Fewer previews than fit are centered.
+    double base = MAX((BAR_WIDTH - strip_content_width(app)) / 2.0, 0);
+    return base + app->strip_padding.left + (double)index * strip_step(app) - app->scroll_offset;
+}
+
+// The scroll offset that puts preview index in the middle of the strip, or
+// as close as the ends allow.
+static double strip_offset_for(Application *app, int index) {
+    double center = app->strip_padding.left + (double)index * strip_step(app) + app->slot_width / 2.0;
+    return CLAMP(center - BAR_WIDTH / 2.0, 0, MAX(strip_content_width(app) - BAR_WIDTH, 0));
+}
+
+static void strip_bind_slot(Application *app, PreviewSlot *slot, int index) {
+    WallpaperItem *item = g_ptr_array_index(app->items, index);
+    cairo_surface_t *surface = g_hash_table_lookup(app->preview_cache, GINT_TO_POINTER(index));
+    slot->index = index;
+    gtk_image_set_from_surface(slot->image, surface ? surface : app->placeholder);
+    gtk_label_set_text(slot->label, item->name);
+
+    GtkStyleContext *context = gtk_widget_get_style_context(slot->event_box);
+    if (index == app->selected_index) {
+        gtk_style_context_add_class(context, "selected");
+    } else {
+        gtk_style_context_remove_class(context, "selected");
     }
-    gtk_main_quit();
 }
 
-static void ui_center_selected_item(Application *app) {
-    if (g_list_length(app->previews) == 0) return;
+// Places the previews in view (and PREVIEW_MARGIN_SLOTS either side) for the
+// current scroll offset, rebinding the slots of those that left to those that
+// came in. Preview i is always shown by slot i % n_slots, so scrolling by one
+// preview rebinds one slot.
+static void strip_layout(Application *app) {
+    int count = app->items->len;
+    int step = strip_step(app);
+    double x0 = strip_item_x(app, 0);
+    int first = MAX((int)floor(-x0 / step) - PREVIEW_MARGIN_SLOTS, 0);
+    int last = MIN((int)floor((BAR_WIDTH - x0) / step) + PREVIEW_MARGIN_SLOTS, count - 1);
+    last = MIN(last, first + app->n_slots - 1);
+
+    for (int s = 0; s < app->n_slots; s++) {
+        app->slots[s].placed = FALSE;
+    }
+    for (int i = first; i <= last; i++) {
+        PreviewSlot *slot = &app->slots[i % app->n_slots];
+        if (slot->index != i) {
+            strip_bind_slot(app, slot, i);
+        }
+        gtk_fixed_move(app->strip, slot->event_box, (int)floor(x0 + (double)i * step + 0.5), app->strip_padding.top);
+        gtk_widget_set_visible(slot->event_box, TRUE);
+        slot->placed = TRUE;
+    }
+    for (int s = 0; s < app->n_slots; s++) {
+        if (!app->slots[s].placed) {
+            gtk_widget_set_visible(app->slots[s].event_box, FALSE);
+        }
+    }
+
+    if (count > 0) {
+        g_atomic_int_set(&app->decode_focus, CLAMP((int)floor((BAR_WIDTH / 2.0 - x0) / step), 0, count - 1));
+    }
+}
+
+static void strip_scroll_to(Application *app, double offset) {
+    app->scroll_offset = CLAMP(offset, 0, MAX(strip_content_width(app) - BAR_WIDTH, 0));
+    strip_layout(app);
+    decode_schedule(app);
+}
+
+static gboolean on_scroll_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data) {
+    Application *app = user_data;
+    double t = (double)(gdk_frame_clock_get_frame_time(frame_clock) - app->scroll_start_time) / SCROLL_DURATION_US;
+    if (t >= 1.0) {
+        app->scroll_tick_id = 0;
+        strip_scroll_to(app, app->scroll_target);
+        return G_SOURCE_REMOVE;
+    }
+    double eased = 1.0 - pow(1.0 - t, 3); // Ease out
+    strip_scroll_to(app, app->scroll_from + (app->scroll_target - app->scroll_from) * eased);
+    return G_SOURCE_CONTINUE;
+}
 
-    GtkWidget *selected_widget = g_list_nth_data(app->previews, app->selected_index);
-    if (!selected_widget) return;
+static void strip_stop_animation(Application *app) {
+    if (app->scroll_tick_id) {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(app->strip), app->scroll_tick_id);
+        app->scroll_tick_id = 0;
+    }
+}
 
-    GtkAdjustment *hadjustment = gtk_scrolled_window_get_hadjustment(app->scrolled_window);
+// Scrolls to offset over the next frames. A new target while one is running
+// restarts the animation from where the strip is, so holding a key down
+// glides along instead of jumping.
+static void strip_animate_to(Application *app, double offset) {
+    GdkFrameClock *frame_clock = gtk_widget_get_frame_clock(GTK_WIDGET(app->strip));
+    gboolean animations = TRUE;
+    g_object_get(gtk_widget_get_settings(GTK_WIDGET(app->strip)), "gtk-enable-animations", &animations, NULL);
+    if (!frame_clock || !animations || fabs(offset - app->scroll_offset) > BAR_WIDTH) {
+        strip_stop_animation(app);
+        strip_scroll_to(app, offset);
+        return;
+    }
 
-    int item_width = gtk_widget_get_allocated_width(selected_widget);
-    int item_x;
-    gtk_widget_translate_coordinates(selected_widget, GTK_WIDGET(app->hbox), 0, 0, &item_x, NULL);
+    app->scroll_from = app->scroll_offset;
+    app->scroll_target = offset;
+    app->scroll_start_time = gdk_frame_clock_get_frame_time(frame_clock);
+    if (!app->scroll_tick_id) {
+        app->scroll_tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(app->strip), on_scroll_tick, app, NULL);
+    }
+}
 
-    double viewport_width = gtk_adjustment_get_page_size(hadjustment);
-    double new_scroll_value = item_x + (double)item_width / 2.0 - viewport_width / 2.0;
 
-    double lower = gtk_adjustment_get_lower(hadjustment);
-    double upper = gtk_adjustment_get_upper(hadjustment) - viewport_width;
-    if (upper < lower) upper = lower;
+// --- Core Logic & Event Handlers ---
 
-    gtk_adjustment_set_value(hadjustment, CLAMP(new_scroll_value, lower, upper));
+static void app_select_and_quit(Application *app, int index) {
+    WallpaperItem *item = g_ptr_array_index(app->items, index);
+    g_print("%s\n", item->path);
+    fflush(stdout);
+    gtk_main_quit();
 }
 
-static void app_update_view(Application *app) {
-    if (g_list_length(app->previews) == 0) return;
+// Moves the highlight from previous_index (-1 for none) to the selected
+// preview, restyling only those two, and scrolls the latter to the middle.
+// Slots bound later pick the highlight up in strip_bind_slot().
+static void app_update_view(Application *app, int previous_index) {
+    if (app->items->len == 0) return;
 
-    for (GList *l = app->previews; l != NULL; l = g_list_next(l)) {
-        GtkWidget *widget = l->data;
-        GtkStyleContext *context = gtk_widget_get_style_context(widget);
-        int index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(widget), "widget-index"));
-        if (index == app->selected_index) {
-            gtk_style_context_add_class(context, "selected");
-        } else {
-            gtk_style_context_remove_class(context, "selected");
+    strip_animate_to(app, strip_offset_for(app, app->selected_index));
+
+    if (previous_index >= 0) {
+        PreviewSlot *previous = &app->slots[previous_index % app->n_slots];
+        if (previous->index == previous_index) {
+            gtk_style_context_remove_class(gtk_widget_get_style_context(previous->event_box), "selected");
         }
     }
-
-    GtkWidget *selected_widget = g_list_nth_data(app->previews, app->selected_index);
-    if (selected_widget) {
-        gtk_widget_grab_focus(selected_widget);
+    PreviewSlot *selected = &app->slots[app->selected_index % app->n_slots];
+    if (selected->index == app->selected_index) {
+        gtk_style_context_add_class(gtk_widget_get_style_context(selected->event_box), "selected");
     }
-    
-    ui_center_selected_item(app);
 }
 
 static gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, Application *app) {
-    int count = g_list_length(app->previews);
-    if (count == 0) return FALSE;
+    int count = app->items->len;
+    int previous_index = app->selected_index;
 
     switch (event->keyval) {
         case GDK_KEY_Left:
         case GDK_KEY_h:
+            if (count == 0) return TRUE;
             app->selected_index = (app->selected_index - 1 + count) % count;
-            app_update_view(app);
+            app_update_view(app, previous_index);
             return TRUE;
 
         case GDK_KEY_Right:
         case GDK_KEY_l:
+            if (count == 0) return TRUE;
             app->selected_index = (app->selected_index + 1) % count;
-            app_update_view(app);
+            app_update_view(app, previous_index);
             return TRUE;
 
         case GDK_KEY_Return:
         case GDK_KEY_KP_Enter:
-            {
-                GtkWidget *selected = g_list_nth_data(app->previews, app->selected_index);
-                if (selected) {
-                    app_select_and_quit(selected);
-                }
+            if (app->selected_index >= 0) {
+                app_select_and_quit(app, app->selected_index);
             }
             return TRUE;
 
@@ -126,109 +309,601 @@ static gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, Application
     return FALSE;
 }
 
-static gboolean on_item_clicked(GtkWidget *event_box, GdkEventButton *event, gpointer user_data) {
+static gboolean on_item_clicked(GtkWidget *event_box, GdkEventButton *event, Application *app) {
     if (event->type == GDK_BUTTON_PRESS && event->button == 1) {
-        app_select_and_quit(event_box);
+        int slot = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(event_box), "slot-index"));
+        app_select_and_quit(app, app->slots[slot].index);
     }
     return FALSE;
 }
 
+// The wheel scrolls the strip without moving the selection.
+static gboolean on_strip_scroll(GtkWidget *widget, GdkEventScroll *event, Application *app) {
+    double delta = 0;
+    switch (event->direction) {
+        case GDK_SCROLL_UP:
+        case GDK_SCROLL_LEFT:
+            delta = -1;
+            break;
+        case GDK_SCROLL_DOWN:
+        case GDK_SCROLL_RIGHT:
+            delta = 1;
+            break;
+        case GDK_SCROLL_SMOOTH:
+            delta = event->delta_x + event->delta_y;
+            break;
+    }
+    double offset = app->scroll_tick_id ? app->scroll_target : app->scroll_offset;
+    strip_stop_animation(app);
+    strip_scroll_to(app, offset + delta * strip_step(app) / 2);
+    return TRUE;
+}
 
-// --- Asynchronous Image Loading ---
 
-static void load_image_thread_func(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable) {
-    char *path = task_data;
-    GError *error = NULL;
+// --- Thumbnail Decoders ---
+//
+// Wallpapers are far larger than their thumbnails, so these decode straight
+// to (about) thumbnail size where the format allows it, rather than going
+// through a full-resolution pixbuf. Each returns NULL for anything it can't
+// handle, which is then left to gdk-pixbuf.
+
+// Size of a width x height image scaled down to fit max x max, keeping its
+// aspect ratio. Images that already fit keep their size.
+static void thumb_fit_size(int width, int height, int max, int *fit_width, int *fit_height) {
+    double scale = MIN((double)max / width, (double)max / height);
+    if (scale >= 1.0) {
+        *fit_width = width;
+        *fit_height = height;
+    } else {
+        *fit_width = MAX((int)(width * scale + 0.5), 1);
+        *fit_height = MAX((int)(height * scale + 0.5), 1);
+    }
+}
 
-    // BEST PRACTICE: Check for cancellation *before* doing expensive I/O.
-    if (g_cancellable_is_cancelled(cancellable)) {
-        g_task_return_error(task, g_error_new_literal(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Image loading cancelled on shutdown"));
-        return;
+typedef struct {
+    struct jpeg_error_mgr pub;
+    jmp_buf escape;
+} JpegErrorManager;
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    longjmp(((JpegErrorManager *)cinfo->err)->escape, 1);
+}
+
+static void jpeg_output_nothing(j_common_ptr cinfo) {
+    // Corrupt-data warnings would only clutter stderr; the image still decodes.
+}
+
+// Decodes a JPEG with libjpeg-turbo's DCT scaling, reduced by the largest of
+// 1/2, 1/4 and 1/8 that still leaves at least the thumbnail's size. A 4K
+// wallpaper never exists at more than 480x270.
+static GdkPixbuf* thumb_decode_jpeg(const guint8 *data, gsize size) {
+    struct jpeg_decompress_struct cinfo;
+    JpegErrorManager err;
+    GdkPixbuf *volatile pixbuf = NULL;
+
+    cinfo.err = jpeg_std_error(&err.pub);
+    err.pub.error_exit = jpeg_error_exit;
+    err.pub.output_message = jpeg_output_nothing;
+    if (setjmp(err.escape)) {
+        jpeg_destroy_decompress(&cinfo);
+        if (pixbuf) g_object_unref(pixbuf);
+        return NULL;
     }
-    
-    GdkPixbuf *final_pixbuf = NULL;
-    gboolean is_uncertain = FALSE;
-    char *mime_type = g_content_type_guess(path, NULL, 0, &is_uncertain);
-    if (mime_type && g_content_type_equals(mime_type, "image/gif")) {
-        GdkPixbufAnimation *anim = gdk_pixbuf_animation_new_from_file(path, &error);
-        if (anim) {
-            GdkPixbuf *first_frame = gdk_pixbuf_animation_get_static_image(anim);
-            if (first_frame) {
-                final_pixbuf = gdk_pixbuf_scale_simple(first_frame, PREVIEW_WIDTH, PREVIEW_HEIGHT, GDK_INTERP_BILINEAR);
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (unsigned char *)data, size);
+    jpeg_read_header(&cinfo, TRUE);
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+
+    int fit_width, fit_height;
+    thumb_fit_size(cinfo.image_width, cinfo.image_height, THUMB_SIZE, &fit_width, &fit_height);
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    for (unsigned int denom = 2; denom <= 8; denom *= 2) {
+        if ((cinfo.image_width + denom - 1) / denom < (unsigned int)fit_width ||
+            (cinfo.image_height + denom - 1) / denom < (unsigned int)fit_height) {
+            break;
+        }
+        cinfo.scale_denom = denom;
+    }
+    cinfo.out_color_space = JCS_RGB;
+    cinfo.dct_method = JDCT_ISLOW;
+    jpeg_start_decompress(&cinfo);
+
+    pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, cinfo.output_width, cinfo.output_height);
+    if (!pixbuf) {
+        jpeg_destroy_decompress(&cinfo);
+        return NULL;
+    }
+    guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
+    int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = pixels + (gsize)cinfo.output_scanline * rowstride;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return pixbuf;
+}
+
+// Decodes a still WebP with libwebp's scaler, which resamples each row as it
+// is decoded, so only the thumbnail-sized output is ever held.
+static GdkPixbuf* thumb_decode_webp(const guint8 *data, gsize size) {
+    WebPDecoderConfig config;
+    if (!WebPInitDecoderConfig(&config) || WebPGetFeatures(data, size, &config.input) != VP8_STATUS_OK ||
+        config.input.has_animation) {
+        return NULL;
+    }
+
+    int width, height;
+    thumb_fit_size(config.input.width, config.input.height, THUMB_SIZE, &width, &height);
+    GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+    if (!pixbuf) return NULL;
+
+    if (width != config.input.width || height != config.input.height) {
+        config.options.use_scaling = 1;
+        config.options.scaled_width = width;
+        config.options.scaled_height = height;
+    }
+    config.output.colorspace = MODE_RGBA;
+    config.output.is_external_memory = 1;
+    config.output.u.RGBA.rgba = gdk_pixbuf_get_pixels(pixbuf);
+    config.output.u.RGBA.stride = gdk_pixbuf_get_rowstride(pixbuf);
+    config.output.u.RGBA.size = gdk_pixbuf_get_byte_length(pixbuf);
+    VP8StatusCode status = WebPDecode(data, size, &config);
+    WebPFreeDecBuffer(&config.output);
+    if (status != VP8_STATUS_OK) {
+        g_object_unref(pixbuf);
+        return NULL;
+    }
+    return pixbuf;
+}
+
+typedef struct {
+    const guint8 *data;
+    gsize size;
+    gsize offset;
+} GifSource;
+
+static int gif_read(GifFileType *gif, GifByteType *buffer, int length) {
+    GifSource *source = gif->UserData;
+    gsize n = MIN((gsize)length, source->size - source->offset);
+    memcpy(buffer, source->data + source->offset, n);
+    source->offset += n;
+    return n;
+}
+
+// Reads the image whose descriptor comes next onto a transparent canvas of
+// the GIF's screen size.
+static GdkPixbuf* gif_read_frame(GifFileType *gif, int transparent) {
+    if (DGifGetImageDesc(gif) == GIF_ERROR) return NULL;
+    const GifImageDesc *desc = &gif->Image;
+    const ColorMapObject *colors = desc->ColorMap ? desc->ColorMap : gif->SColorMap;
+    if (!colors || desc->Width <= 0 || desc->Height <= 0 || gif->SWidth <= 0 || gif->SHeight <= 0) return NULL;
+
+    GdkPixbuf *canvas = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, gif->SWidth, gif->SHeight);
+    if (!canvas) return NULL;
+    gdk_pixbuf_fill(canvas, 0);
+    guchar *pixels = gdk_pixbuf_get_pixels(canvas);
+    int rowstride = gdk_pixbuf_get_rowstride(canvas);
+    GifPixelType *line = g_new(GifPixelType, desc->Width);
+
+    // Interlaced images come in four passes over every 8th, 8th, 4th and 2nd row.
+    static const int pass_start[] = { 0, 4, 2, 1 };
+    static const int pass_step[] = { 8, 8, 4, 2 };
+    int n_passes = desc->Interlace ? 4 : 1;
+    for (int pass = 0; pass < n_passes; pass++) {
+        int step = desc->Interlace ? pass_step[pass] : 1;
+        for (int y = desc->Interlace ? pass_start[pass] : 0; y < desc->Height; y += step) {
+            if (DGifGetLine(gif, line, desc->Width) == GIF_ERROR) {
+                g_free(line);
+                g_object_unref(canvas);
+                return NULL;
+            }
+            int canvas_y = desc->Top + y;
+            if (canvas_y < 0 || canvas_y >= gif->SHeight) continue;
+            guchar *row = pixels + (gsize)canvas_y * rowstride;
+            for (int x = 0; x < desc->Width; x++) {
+                int canvas_x = desc->Left + x;
+                if (canvas_x < 0 || canvas_x >= gif->SWidth || line[x] == transparent || line[x] >= colors->ColorCount) continue;
+                const GifColorType *color = &colors->Colors[line[x]];
+                guchar *pixel = row + canvas_x * 4;
+                pixel[0] = color->Red;
+                pixel[1] = color->Green;
+                pixel[2] = color->Blue;
+                pixel[3] = 0xFF;
             }
-            g_object_unref(anim);
         }
     }
-    g_free(mime_type);
+    g_free(line);
+    return canvas;
+}
 
-    if (final_pixbuf == NULL) {
-        g_clear_error(&error);
-        final_pixbuf = gdk_pixbuf_new_from_file_at_size(path, PREVIEW_WIDTH, PREVIEW_HEIGHT, &error);
+// Decodes the first frame of a GIF with giflib and stops there, where
+// gdk-pixbuf would build every frame of the animation.
+static GdkPixbuf* thumb_decode_gif(const guint8 *data, gsize size) {
+    GifSource source = { data, size, 0 };
+    int error;
+    GifFileType *gif = DGifOpen(&source, gif_read, &error);
+    if (!gif) return NULL;
+
+    GdkPixbuf *frame = NULL;
+    int transparent = NO_TRANSPARENT_COLOR;
+    GifRecordType type;
+    gboolean ok = TRUE;
+    while (ok && DGifGetRecordType(gif, &type) == GIF_OK && type != TERMINATE_RECORD_TYPE) {
+        if (type == IMAGE_DESC_RECORD_TYPE) {
+            frame = gif_read_frame(gif, transparent);
+            break;
+        }
+        if (type != EXTENSION_RECORD_TYPE) continue;
+
+        int code;
+        GifByteType *extension;
+        ok = DGifGetExtension(gif, &code, &extension) == GIF_OK;
+        while (ok && extension) {
+            GraphicsControlBlock gcb;
+            if (code == GRAPHICS_EXT_FUNC_CODE && DGifExtensionToGCB(extension[0], extension + 1, &gcb) == GIF_OK) {
+                transparent = gcb.TransparentColor;
+            }
+            ok = DGifGetExtensionNext(gif, &extension) == GIF_OK;
+        }
     }
+    DGifCloseFile(gif, &error);
+    return frame;
+}
 
-    if (error) {
-        // g_warning("Failed to load image '%s': %s", path, error->message);
-        g_task_return_error(task, g_error_copy(error));
-        g_error_free(error);
-        return;
+
+// --- Thumbnail Cache ---
+
+// Scales pixbuf down to fit width x height, keeping its aspect ratio.
+static GdkPixbuf* thumb_scale_to_fit(GdkPixbuf *pixbuf, int width, int height) {
+    int src_width = gdk_pixbuf_get_width(pixbuf);
+    int src_height = gdk_pixbuf_get_height(pixbuf);
+    double scale = MIN((double)width / src_width, (double)height / src_height);
+    if (scale >= 1.0) {
+        return g_object_ref(pixbuf);
     }
+    return gdk_pixbuf_scale_simple(pixbuf, MAX((int)(src_width * scale + 0.5), 1),
+                                   MAX((int)(src_height * scale + 0.5), 1), GDK_INTERP_BILINEAR);
+}
 
-    g_task_return_pointer(task, final_pixbuf, g_object_unref);
+// Path of the thumbnail (or failure marker) of the file with the given URI
+// inside ~/.cache/thumbnails/<subdir>.
+static char* thumb_path_for_uri(const char *uri, const char *subdir) {
+    char *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+    char *file_name = g_strconcat(md5, ".png", NULL);
+    char *path = g_build_filename(g_get_user_cache_dir(), "thumbnails", subdir, file_name, NULL);
+    g_free(file_name);
+    g_free(md5);
+    return path;
+}
+
+// Loads a cached thumbnail if it was made from the file as it is now: same
+// URI, mtime and (when the thumbnailer recorded it) size.
+static GdkPixbuf* thumb_cache_lookup(const char *thumb_path, const char *uri, const GStatBuf *st) {
+    GdkPixbuf *thumb = gdk_pixbuf_new_from_file(thumb_path, NULL);
+    if (!thumb) return NULL;
+
+    const char *thumb_uri = gdk_pixbuf_get_option(thumb, "tEXt::Thumb::URI");
+    const char *thumb_mtime = gdk_pixbuf_get_option(thumb, "tEXt::Thumb::MTime");
+    const char *thumb_size = gdk_pixbuf_get_option(thumb, "tEXt::Thumb::Size");
+    if (g_strcmp0(thumb_uri, uri) != 0 || !thumb_mtime ||
+        g_ascii_strtoll(thumb_mtime, NULL, 10) != (gint64)st->st_mtime ||
+        (thumb_size && g_ascii_strtoll(thumb_size, NULL, 10) != (gint64)st->st_size)) {
+        g_object_unref(thumb);
+        return NULL;
+    }
+    return thumb;
 }
 
-static void on_image_loaded_cb(GObject *source_object, GAsyncResult *res, gpointer user_data) {
-    GtkImage *image = GTK_IMAGE(user_data);
+// Writes thumb with the keys the spec asks for, through a temporary file so
+// that readers never see half a PNG.
+static void thumb_cache_store(const char *thumb_path, GdkPixbuf *thumb, const char *uri, const GStatBuf *st) {
+    char *dir = g_path_get_dirname(thumb_path);
+    g_mkdir_with_parents(dir, 0700);
+    g_free(dir);
+
+    char *tmp_path = g_strconcat(thumb_path, ".XXXXXX", NULL);
+    int fd = g_mkstemp_full(tmp_path, O_WRONLY, 0600);
+    if (fd < 0) {
+        g_free(tmp_path);
+        return;
+    }
+    close(fd);
+
+    char *mtime = g_strdup_printf("%" G_GINT64_FORMAT, (gint64)st->st_mtime);
+    char *size = g_strdup_printf("%" G_GINT64_FORMAT, (gint64)st->st_size);
     GError *error = NULL;
-    GdkPixbuf *pixbuf = g_task_propagate_pointer(G_TASK(res), &error);
+    if (!gdk_pixbuf_save(thumb, tmp_path, "png", &error,
+                         "tEXt::Thumb::URI", uri, "tEXt::Thumb::MTime", mtime, "tEXt::Thumb::Size", size,
+                         "tEXt::Software", "cachy-selector", NULL) ||
+        g_rename(tmp_path, thumb_path) != 0) {
+        if (error) {
+            g_warning("Failed to write thumbnail '%s': %s", thumb_path, error->message);
+            g_error_free(error);
+        }
+        g_unlink(tmp_path);
+    }
+    g_free(size);
+    g_free(mtime);
+    g_free(tmp_path);
+}
+
+// Decodes the image at path, scaled down to fit THUMB_SIZE. GIFs give their
+// first frame. The format is told by the file's signature, not its name.
+static GdkPixbuf* thumb_generate(const char *path, GError **error) {
+    GMappedFile *file = g_mapped_file_new(path, FALSE, error);
+    if (!file) return NULL;
+    const guint8 *data = (const guint8 *)g_mapped_file_get_contents(file);
+    gsize size = g_mapped_file_get_length(file);
+
+    GdkPixbuf *decoded = NULL;
+    if (size >= 3 && memcmp(data, "\xFF\xD8\xFF", 3) == 0) {
+        decoded = thumb_decode_jpeg(data, size);
+    } else if (size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0) {
+        decoded = thumb_decode_webp(data, size);
+    } else if (size >= 6 && (memcmp(data, "GIF87a", 6) == 0 || memcmp(data, "GIF89a", 6) == 0)) {
+        decoded = thumb_decode_gif(data, size);
+    }
+    g_mapped_file_unref(file);
+
+    if (decoded) {
+        GdkPixbuf *thumb = thumb_scale_to_fit(decoded, THUMB_SIZE, THUMB_SIZE);
+        g_object_unref(decoded);
+        return thumb;
+    }
 
-    if (error) {
-        // BEST PRACTICE: Don't warn on cancellation, it's an expected outcome.
-        if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-            g_warning("Async image load failed: %s", error->message);
+    int width = 0, height = 0;
+    // The spec doesn't want small images scaled up.
+    if (gdk_pixbuf_get_file_info(path, &width, &height) && width <= THUMB_SIZE && height <= THUMB_SIZE) {
+        return gdk_pixbuf_new_from_file(path, error);
+    }
+    return gdk_pixbuf_new_from_file_at_size(path, THUMB_SIZE, THUMB_SIZE, error);
+}
+
+// Returns the thumbnail of path, from the cache if it holds one for the file as
+// it is now, otherwise decoded and stored for next time. Files that failed to
+// decode get a failure marker, so they aren't tried again until they change.
+// was_cached, if not NULL, tells which of the two happened.
+static GdkPixbuf* thumb_cache_get(const char *path, gboolean *was_cached, GError **error) {
+    if (was_cached) *was_cached = FALSE;
+    GStatBuf st;
+    if (g_stat(path, &st) != 0) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot stat '%s'", path);
+        return NULL;
+    }
+    // URIs need an absolute path, and paths piped in may be relative.
+    char *absolute = g_canonicalize_filename(path, NULL);
+    char *uri = g_filename_to_uri(absolute, NULL, error);
+    g_free(absolute);
+    if (!uri) return NULL;
+
+    char *thumb_path = thumb_path_for_uri(uri, THUMB_FLAVOR);
+    char *fail_dir = g_build_filename("fail", THUMB_FAIL_DIR, NULL);
+    char *fail_path = thumb_path_for_uri(uri, fail_dir);
+    GdkPixbuf *thumb = thumb_cache_lookup(thumb_path, uri, &st);
+    GdkPixbuf *marker = NULL;
+
+    if (thumb) {
+        if (was_cached) *was_cached = TRUE;
+    } else if ((marker = thumb_cache_lookup(fail_path, uri, &st))) {
+        if (was_cached) *was_cached = TRUE;
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "'%s' failed to decode before", path);
+        g_object_unref(marker);
+    } else if ((thumb = thumb_generate(path, error))) {
+        thumb_cache_store(thumb_path, thumb, uri, &st);
+    } else {
+        marker = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 1, 1);
+        gdk_pixbuf_fill(marker, 0);
+        thumb_cache_store(fail_path, marker, uri, &st);
+        g_object_unref(marker);
+    }
+
+    g_free(fail_path);
+    g_free(fail_dir);
+    g_free(thumb_path);
+    g_free(uri);
+    return thumb;
+}
+
+
+// --- Decode Scheduler ---
+
+typedef struct {
+    Application *app;
+    WallpaperItem *item;
+    cairo_surface_t *surface;
+} DecodeResult;
+
+// How far index is from the middle of the view, counting around the ends
+// since navigation wraps.
+static int decode_distance(Application *app, int index) {
+    int count = g_atomic_int_get(&app->n_items);
+    int distance = ABS(index - g_atomic_int_get(&app->decode_focus));
+    return MIN(distance, count - distance);
+}
+
+static gint decode_compare_items(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const WallpaperItem *item_a = a;
+    const WallpaperItem *item_b = b;
+    return decode_distance(user_data, item_a->index) - decode_distance(user_data, item_b->index);
+}
+
+static void wallpaper_item_free(gpointer data) {
+    WallpaperItem *item = data;
+    g_free(item->path);
+    g_free(item);
+}
+
+// Converts a preview to the premultiplied, native-endian ARGB that cairo
+// draws from, so the main thread can hand it to GTK without converting it.
+static cairo_surface_t* decode_surface_from_pixbuf(GdkPixbuf *pixbuf) {
+    int width = gdk_pixbuf_get_width(pixbuf);
+    int height = gdk_pixbuf_get_height(pixbuf);
+    int n_channels = gdk_pixbuf_get_n_channels(pixbuf);
+    int src_stride = gdk_pixbuf_get_rowstride(pixbuf);
+    const guchar *src = gdk_pixbuf_read_pixels(pixbuf);
+
+    cairo_surface_t *surface = cairo_image_surface_create(n_channels == 4 ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                                          width, height);
+    guchar *dst = cairo_image_surface_get_data(surface);
+    int dst_stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < height; y++) {
+        const guchar *in = src + (gsize)y * src_stride;
+        guint32 *out = (guint32 *)(dst + (gsize)y * dst_stride);
+        for (int x = 0; x < width; x++, in += n_channels) {
+            guint r = in[0], g = in[1], b = in[2];
+            guint a = n_channels == 4 ? in[3] : 0xFF;
+            if (a != 0xFF) {
+                r = (r * a + 127) / 255;
+                g = (g * a + 127) / 255;
+                b = (b * a + 127) / 255;
+            }
+            out[x] = a << 24 | r << 16 | g << 8 | b;
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+// Keeps surface as the preview of item index. Past PREVIEW_CACHE_SIZE the
+// preview farthest from the view is dropped; it is decoded again, from the
+// thumbnail cache, if the view comes back to it.
+static void preview_cache_insert(Application *app, int index, cairo_surface_t *surface) {
+    g_hash_table_replace(app->preview_cache, GINT_TO_POINTER(index), surface);
+    if (g_hash_table_size(app->preview_cache) <= (guint)PREVIEW_CACHE_SIZE) return;
+
+    GHashTableIter iter;
+    gpointer key;
+    int farthest = index;
+    int farthest_distance = -1;
+    g_hash_table_iter_init(&iter, app->preview_cache);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        int distance = decode_distance(app, GPOINTER_TO_INT(key));
+        if (distance > farthest_distance) {
+            farthest = GPOINTER_TO_INT(key);
+            farthest_distance = distance;
+        }
+    }
+    g_hash_table_remove(app->preview_cache, GINT_TO_POINTER(farthest));
+    WallpaperItem *item = g_ptr_array_index(app->items, farthest);
+    g_atomic_int_set(&item->state, DECODE_IDLE);
+}
+
+static gboolean on_decode_done(gpointer data) {
+    DecodeResult *result = data;
+    Application *app = result->app;
+    int index = result->item->index;
+
+    PreviewSlot *slot = &app->slots[index % app->n_slots];
+    if (slot->index == index) {
+        gtk_image_set_from_surface(slot->image, result->surface);
+    }
+    // Last, as the cache may drop the surface right away.
+    preview_cache_insert(app, index, result->surface);
+    g_free(result);
+    return G_SOURCE_REMOVE;
+}
+
+static void decode_worker(gpointer data, gpointer user_data) {
+    WallpaperItem *item = data;
+    Application *app = user_data;
+
+    if (g_cancellable_is_cancelled(app->cancellable)) return;
+
+    // Scrolled away from while it waited: defer it until the view is near
+    // again, so the pool stays busy with what is on screen.
+    if (decode_distance(app, item->index) > DECODE_WINDOW) {
+        g_atomic_int_set(&item->state, DECODE_IDLE);
+        // The view may have come back meanwhile and skipped the item as queued.
+        if (decode_distance(app, item->index) <= DECODE_WINDOW &&
+            g_atomic_int_compare_and_exchange(&item->state, DECODE_IDLE, DECODE_QUEUED)) {
+            g_thread_pool_push(app->decode_pool, item, NULL);
         }
+        return;
+    }
+
+    // Repeat runs only read the small cached thumbnail.
+    GError *error = NULL;
+    gboolean was_cached;
+    GdkPixbuf *thumb = thumb_cache_get(item->path, &was_cached, &error);
+    g_atomic_int_set(&item->state, DECODE_DONE);
+    if (!thumb) {
+        // A failure marker means this was already reported when it first failed.
+        if (!was_cached) g_warning("Async image load failed: %s", error->message);
         g_error_free(error);
         return;
     }
 
-    if (pixbuf) {
-        gtk_image_set_from_pixbuf(image, pixbuf);
-        g_object_unref(pixbuf);
+    GdkPixbuf *preview = thumb_scale_to_fit(thumb, PREVIEW_WIDTH, PREVIEW_HEIGHT);
+    DecodeResult *result = g_new(DecodeResult, 1);
+    result->app = app;
+    result->item = item;
+    result->surface = decode_surface_from_pixbuf(preview);
+    g_object_unref(preview);
+    g_object_unref(thumb);
+    g_idle_add(on_decode_done, result);
+}
+
+// Queues the previews within DECODE_WINDOW of the middle of the view that are
+// neither decoded nor queued yet, and reorders the queue around it.
+static void decode_schedule(Application *app) {
+    int count = app->items->len;
+    if (count == 0) return;
+
+    int reach = MIN(DECODE_WINDOW, count / 2);
+    for (int offset = -reach; offset <= reach; offset++) {
+        int index = ((app->decode_focus + offset) % count + count) % count;
+        WallpaperItem *item = g_ptr_array_index(app->items, index);
+        if (g_atomic_int_compare_and_exchange(&item->state, DECODE_IDLE, DECODE_QUEUED)) {
+            g_thread_pool_push(app->decode_pool, item, NULL);
+        }
     }
+    // Setting the sort function again re-sorts the items still waiting.
+    g_thread_pool_set_sort_function(app->decode_pool, decode_compare_items, app);
 }
 
 // --- UI Construction ---
 
-static GtkWidget* ui_create_wallpaper_preview(Application *app, const char* path_str, int index) {
-    GdkPixbuf *placeholder = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, PREVIEW_WIDTH, PREVIEW_HEIGHT);
-    gdk_pixbuf_fill(placeholder, 0x1E1E2EFF);
-    GtkWidget *image = gtk_image_new_from_pixbuf(placeholder);
+static void ui_create_preview_slot(Application *app, int slot_index) {
+    PreviewSlot *slot = &app->slots[slot_index];
+
+    GtkWidget *image = gtk_image_new_from_surface(app->placeholder);
     gtk_widget_set_size_request(image, PREVIEW_WIDTH, PREVIEW_HEIGHT);
     gtk_style_context_add_class(gtk_widget_get_style_context(image), "preview-image");
-    g_object_unref(placeholder);
-
-    GTask *task = g_task_new(NULL, app->cancellable, on_image_loaded_cb, image);
-    g_task_set_task_data(task, g_strdup(path_str), g_free);
-    g_task_run_in_thread(task, (GTaskThreadFunc)load_image_thread_func);
-    g_object_unref(task);
 
-    GtkWidget *label = gtk_label_new(g_path_get_basename(path_str));
+    GtkWidget *label = gtk_label_new(NULL);
     gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+    // Takes the width of the preview rather than that of its text, so that
+    // every slot is as wide as the first.
+    gtk_label_set_max_width_chars(GTK_LABEL(label), 1);
     gtk_style_context_add_class(gtk_widget_get_style_context(label), "filename-label");
 
     GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
     gtk_box_pack_start(GTK_BOX(vbox), image, TRUE, TRUE, 0);
     gtk_box_pack_start(GTK_BOX(vbox), label, FALSE, FALSE, 0);
+    gtk_widget_show_all(vbox);
 
     GtkWidget *event_box = gtk_event_box_new();
     gtk_container_add(GTK_CONTAINER(event_box), vbox);
-    gtk_widget_set_can_focus(event_box, TRUE);
+    gtk_widget_set_size_request(event_box, -1, BAR_HEIGHT - app->strip_padding.top - app->strip_padding.bottom);
     gtk_style_context_add_class(gtk_widget_get_style_context(event_box), "preview-item");
-    
-    g_object_set_data_full(G_OBJECT(event_box), "wallpaper-path", g_strdup(path_str), g_free);
-    g_object_set_data(G_OBJECT(event_box), "widget-index", GINT_TO_POINTER(index));
-    g_signal_connect(event_box, "button-press-event", G_CALLBACK(on_item_clicked), NULL);
-
-    return event_box;
+    // Shown by strip_layout() once bound to a wallpaper.
+    gtk_widget_set_no_show_all(event_box, TRUE);
+
+    g_object_set_data(G_OBJECT(event_box), "slot-index", GINT_TO_POINTER(slot_index));
+    g_signal_connect(event_box, "button-press-event", G_CALLBACK(on_item_clicked), app);
+    gtk_fixed_put(app->strip, event_box, 0, app->strip_padding.top);
+
+    slot->event_box = event_box;
+    slot->image = GTK_IMAGE(image);
+    slot->label = GTK_LABEL(label);
+    slot->index = -1;
+    slot->placed = FALSE;
 }
 
 static void ui_load_css() {
@@ -277,39 +952,239 @@ static void ui_build(Application *app) {
     gtk_layer_set_anchor(app->window, GTK_LAYER_SHELL_EDGE_TOP, TRUE);
     gtk_layer_set_margin(app->window, GTK_LAYER_SHELL_EDGE_TOP, TOP_MARGIN);
 
-    app->scrolled_window = GTK_SCROLLED_WINDOW(gtk_scrolled_window_new(NULL, NULL));
-    gtk_widget_set_name(GTK_WIDGET(app->scrolled_window), "scrolled-window");
-    gtk_scrolled_window_set_policy(app->scrolled_window, GTK_POLICY_AUTOMATIC, GTK_POLICY_NEVER);
-    gtk_scrolled_window_set_min_content_width(app->scrolled_window, BAR_WIDTH);
-    gtk_widget_set_size_request(GTK_WIDGET(app->scrolled_window), BAR_WIDTH, BAR_HEIGHT);
-    gtk_container_add(GTK_CONTAINER(app->window), GTK_WIDGET(app->scrolled_window));
-
-    app->hbox = GTK_BOX(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, PREVIEW_SPACING));
-    gtk_widget_set_name(GTK_WIDGET(app->hbox), "main-hbox");
-    gtk_widget_set_halign(GTK_WIDGET(app->hbox), GTK_ALIGN_CENTER);
-    gtk_container_add(GTK_CONTAINER(app->scrolled_window), GTK_WIDGET(app->hbox));
+    app->strip = GTK_FIXED(gtk_fixed_new());
+    gtk_widget_set_name(GTK_WIDGET(app->strip), "main-hbox");
+    // A window of its own clips the previews that are partly scrolled out.
+    gtk_widget_set_has_window(GTK_WIDGET(app->strip), TRUE);
+    gtk_widget_set_size_request(GTK_WIDGET(app->strip), BAR_WIDTH, BAR_HEIGHT);
+    gtk_widget_add_events(GTK_WIDGET(app->strip), GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+    gtk_container_add(GTK_CONTAINER(app->window), GTK_WIDGET(app->strip));
 
     ui_load_css();
 
+    GtkStyleContext *strip_context = gtk_widget_get_style_context(GTK_WIDGET(app->strip));
+    gtk_style_context_get_padding(strip_context, gtk_style_context_get_state(strip_context), &app->strip_padding);
+
+    app->placeholder = cairo_image_surface_create(CAIRO_FORMAT_RGB24, PREVIEW_WIDTH, PREVIEW_HEIGHT);
+    cairo_t *cr = cairo_create(app->placeholder);
+    cairo_set_source_rgb(cr, 0x1E / 255.0, 0x1E / 255.0, 0x2E / 255.0);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+
+    // The first slot tells how wide a preview is with the CSS applied, and so
+    // how many slots it takes to cover the strip.
+    app->n_slots = 1;
+    app->slots = g_new0(PreviewSlot, 1);
+    ui_create_preview_slot(app, 0);
+    gtk_widget_show(app->slots[0].event_box);
+    gtk_widget_get_preferred_width(app->slots[0].event_box, NULL, &app->slot_width);
+    gtk_widget_hide(app->slots[0].event_box);
+    app->slot_width = MAX(app->slot_width, 1);
+
+    app->n_slots = BAR_WIDTH / strip_step(app) + 2 + 2 * PREVIEW_MARGIN_SLOTS;
+    app->slots = g_renew(PreviewSlot, app->slots, app->n_slots);
+    for (int i = 1; i < app->n_slots; i++) {
+        ui_create_preview_slot(app, i);
+    }
+
     g_signal_connect(app->window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
     g_signal_connect(app->window, "key-press-event", G_CALLBACK(on_key_press), app);
+    g_signal_connect(app->strip, "scroll-event", G_CALLBACK(on_strip_scroll), app);
+}
+
+// Decoded, and shown by a slot, once the view comes near; see strip_layout().
+static void app_add_wallpaper(Application *app, const char *path) {
+    WallpaperItem *item = g_new0(WallpaperItem, 1);
+    item->path = g_strdup(path);
+    const char *slash = strrchr(item->path, '/');
+    item->name = slash ? slash + 1 : item->path;
+    item->index = app->items->len;
+    item->state = DECODE_IDLE;
+    g_ptr_array_add(app->items, item);
+    g_atomic_int_set(&app->n_items, app->items->len);
+}
+
+
+// --- Stdin Ingestion ---
+
+// Runs on the ingest pool. An empty batch marks the end of stdin.
+static void ingest_worker(gpointer data, gpointer user_data) {
+    GPtrArray *lines = data;
+    Application *app = user_data;
+
+    if (lines->len == 0) {
+        g_async_queue_push(app->ingest_queue, g_strdup(""));
+    }
+    for (guint i = 0; i < lines->len && !g_cancellable_is_cancelled(app->cancellable); i++) {
+        const char *path = g_ptr_array_index(lines, i);
+        if (g_file_test(path, G_FILE_TEST_EXISTS)) {
+            g_async_queue_push(app->ingest_queue, g_strdup(path));
+        } else {
+            g_warning("File not found, skipping: %s", path);
+        }
+    }
+    g_ptr_array_unref(lines);
+    g_idle_add(on_ingest_ready, app);
 }
 
+static gboolean on_ingest_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data) {
+    Application *app = user_data;
+    gboolean added = FALSE;
+    gboolean finished = FALSE;
+
+    for (int i = 0; i < INGEST_BATCH_SIZE; i++) {
+        char *path = g_async_queue_try_pop(app->ingest_queue);
+        if (!path) {
+            finished = TRUE;
+            break;
+        }
+        if (path[0] == '\0') {
+            g_free(path);
+            finished = TRUE;
+            if (app->items->len == 0) {
+                g_warning("No valid image paths provided via stdin. Exiting.");
+                gtk_main_quit();
+            }
+            break;
+        }
+        app_add_wallpaper(app, path);
+        g_free(path);
+        added = TRUE;
+    }
+
+    if (added) {
+        if (app->selected_index < 0) {
+            app->selected_index = 0;
+            app_update_view(app, -1);
+        } else {
+            // The strip grew: lays out the new previews that are in view and
+            // queues the ones close enough to decode.
+            strip_scroll_to(app, app->scroll_offset);
+        }
+    }
+    if (finished) {
+        app->ingest_tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Paths are waiting: adds them from the next frame on, unless that is arranged already.
+static gboolean on_ingest_ready(gpointer user_data) {
+    Application *app = user_data;
+    if (app->ingest_tick_id == 0) {
+        app->ingest_tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(app->window), on_ingest_tick, app, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void ingest_read_next(Application *app);
+
+static void on_stdin_read(GObject *source, GAsyncResult *res, gpointer user_data) {
+    Application *app = user_data;
+    GError *error = NULL;
+    GBytes *bytes = g_input_stream_read_bytes_finish(G_INPUT_STREAM(source), res, &error);
+    if (!bytes) {
+        if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(error);
+            return;
+        }
+        g_warning("Failed to read stdin: %s", error->message);
+        g_error_free(error);
+    }
+
+    gsize size = bytes ? g_bytes_get_size(bytes) : 0;
+    GPtrArray *lines = g_ptr_array_new_with_free_func(g_free);
+    if (size > 0) {
+        g_string_append_len(app->stdin_partial, g_bytes_get_data(bytes, NULL), size);
+        const char *start = app->stdin_partial->str;
+        const char *end = start + app->stdin_partial->len;
+        const char *newline;
+        while ((newline = memchr(start, '\n', end - start))) {
+            if (newline > start) {
+                g_ptr_array_add(lines, g_strndup(start, newline - start));
+            }
+            start = newline + 1;
+        }
+        g_string_erase(app->stdin_partial, 0, start - app->stdin_partial->str);
+    } else if (app->stdin_partial->len > 0) {
+        // The last line had no newline.
+        g_ptr_array_add(lines, g_strdup(app->stdin_partial->str));
+        g_string_truncate(app->stdin_partial, 0);
+    }
+
+    if (lines->len > 0) {
+        g_thread_pool_push(app->ingest_pool, lines, NULL);
+    } else {
+        g_ptr_array_unref(lines);
+    }
+    if (size > 0) {
+        ingest_read_next(app);
+    } else {
+        g_thread_pool_push(app->ingest_pool, g_ptr_array_new(), NULL);
+    }
+    if (bytes) g_bytes_unref(bytes);
+}
+
+static void ingest_read_next(Application *app) {
+    g_input_stream_read_bytes_async(app->stdin_stream, INGEST_READ_SIZE, G_PRIORITY_DEFAULT,
+                                    app->cancellable, on_stdin_read, app);
+}
+
+// Starts streaming previews in from stdin; they keep arriving while the main loop runs.
 static void app_populate_from_stdin(Application *app) {
+    app->stdin_stream = g_unix_input_stream_new(STDIN_FILENO, FALSE);
+    app->stdin_partial = g_string_new(NULL);
+    app->ingest_queue = g_async_queue_new_full(g_free);
+    app->ingest_pool = g_thread_pool_new(ingest_worker, app, 1, FALSE, NULL);
+    ingest_read_next(app);
+}
+
+
+// --- Cache Warming ---
+
+typedef struct {
+    gint n_cached;   // Counters, updated atomically by the workers
+    gint n_created;
+    gint n_failed;
+} WarmStats;
+
+static void warm_cache_worker(gpointer data, gpointer user_data) {
+    char *path = data;
+    WarmStats *stats = user_data;
+    gboolean was_cached = FALSE;
+    GError *error = NULL;
+    GdkPixbuf *thumb = thumb_cache_get(path, &was_cached, &error);
+    if (thumb) {
+        g_atomic_int_inc(was_cached ? &stats->n_cached : &stats->n_created);
+        g_object_unref(thumb);
+    } else {
+        g_atomic_int_inc(&stats->n_failed);
+        g_error_free(error);
+    }
+    g_free(path);
+}
+
+// Fills the thumbnail cache for the paths on stdin, one image per core at a
+// time, without opening a window. Meant to run in the background at login.
+static int warm_cache_from_stdin(void) {
+    gint64 start = g_get_monotonic_time();
+    WarmStats stats = { 0, 0, 0 };
+    GThreadPool *pool = g_thread_pool_new(warm_cache_worker, &stats, g_get_num_processors(), FALSE, NULL);
+
     char buffer[4096];
-    int index = 0;
     while (fgets(buffer, sizeof(buffer), stdin)) {
         buffer[strcspn(buffer, "\n")] = 0; // Strip newline
         if (buffer[0] == '\0') continue;
-        if (!g_file_test(buffer, G_FILE_TEST_EXISTS)) {
-            g_warning("File not found, skipping: %s", buffer);
-            continue;
-        }
-
-        GtkWidget *preview = ui_create_wallpaper_preview(app, buffer, index++);
-        gtk_box_pack_start(app->hbox, preview, FALSE, FALSE, 0);
-        app->previews = g_list_append(app->previews, preview);
+        g_thread_pool_push(pool, g_strdup(buffer), NULL);
     }
+    // Waits for every queued image to be done.
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    g_message("Thumbnail cache warmed in %.2f s: %d created, %d already cached, %d failed",
+              (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC,
+              stats.n_created, stats.n_cached, stats.n_failed);
+    return 0;
 }
 
 
@@ -319,6 +1194,11 @@ Application* app_new() {
     Application *app = g_new0(Application, 1);
     app->selected_index = -1;
     app->cancellable = g_cancellable_new();
+    app->items = g_ptr_array_new_with_free_func(wallpaper_item_free);
+    app->preview_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+                                               (GDestroyNotify)cairo_surface_destroy);
+    app->decode_pool = g_thread_pool_new(decode_worker, app, MIN(g_get_num_processors(), DECODE_MAX_THREADS), TRUE, NULL);
+    g_thread_pool_set_sort_function(app->decode_pool, decode_compare_items, app);
     return app;
 }
 
@@ -328,33 +1208,45 @@ void app_free(Application *app) {
     // BEST PRACTICE: Cancel all pending async operations first.
     // This immediately signals all background threads to stop their work.
     g_cancellable_cancel(app->cancellable);
+    if (app->ingest_pool) {
+        g_thread_pool_free(app->ingest_pool, TRUE, TRUE);
+        g_async_queue_unref(app->ingest_queue);
+        g_string_free(app->stdin_partial, TRUE);
+        g_object_unref(app->stdin_stream);
+    }
+    // Drops the queued thumbnails and waits for the ones being decoded.
+    g_thread_pool_free(app->decode_pool, TRUE, TRUE);
+    g_ptr_array_free(app->items, TRUE);
+    g_hash_table_destroy(app->preview_cache);
     
-    // The widgets in the list are children of the main window, which GTK will
+    // The slot widgets are children of the main window, which GTK will
     // destroy and unref automatically when gtk_main_quit() is called.
-    // We only need to free the list container itself.
-    g_list_free(app->previews);
+    // We only need to free the array describing them.
+    g_free(app->slots);
+    if (app->placeholder) cairo_surface_destroy(app->placeholder);
     
     g_object_unref(app->cancellable);
     g_free(app);
 }
 
 int main(int argc, char *argv[]) {
+    // Cache warming needs no display, so it runs before GTK is initialized.
+    for (int i = 1; i < argc; i++) {
+        if (g_strcmp0(argv[i], "--warm-cache") == 0) {
+            return warm_cache_from_stdin();
+        }
+    }
+
     gtk_init(&argc, &argv);
 
     Application *app = app_new();
     
     ui_build(app);
+    // The window maps right away; previews fill in as stdin delivers them,
+    // and the app quits by itself if none turn out to be valid.
+    gtk_widget_show_all(GTK_WIDGET(app->window));
     app_populate_from_stdin(app);
-
-    // BEST PRACTICE: Only run the app if there's something to show.
-    if (g_list_length(app->previews) > 0) {
-        gtk_widget_show_all(GTK_WIDGET(app->window));
-        app->selected_index = 0;
-        app_update_view(app);
-        gtk_main();
-    } else {
-        g_warning("No valid image paths provided via stdin. Exiting.");
-    }
+    gtk_main();
 
     app_free(app);
 
@@ -858,6 +858,59 @@ else
 fi
 # ---
 
+# The path to our custom selector, located in the same directory as this script.
+# This is the robust way to call it, no matter where you run wallpaper.sh from.
+SELECTOR_PATH="$(dirname "$0")/cachy-selector"
+
+# Rebuilds the selector when its source is newer than the binary, where make
+# is available, so the binary keeps up with the options this script passes it.
+build_selector() {
+    if command -v make &> /dev/null && [ -f "$(dirname "$0")/Makefile" ]; then
+        make -s -C "$(dirname "$0")" cachy-selector
+    fi
+}
+
+# Whether the selector knows --warm-cache. Older builds ignore their arguments
+# and would open the selector instead, so look for the option in the binary
+# rather than running it.
+selector_can_warm_cache() {
+    [ -x "$SELECTOR_PATH" ] && grep -qaF -- '--warm-cache' "$SELECTOR_PATH"
+}
+
+# Prints the full path of every wallpaper, sorted.
+list_wallpapers() {
+    if command -v fd &> /dev/null; then
+        fd . "$WALLPAPER_DIR" -e png -e jpg -e jpeg -e gif -e webp --type f | sort
+    else
+        find "$WALLPAPER_DIR" -type f \( -iname '*.png' -o -iname '*.jpeg' -o -iname '*.jpg' -o -iname '*.gif' -o -iname '*.webp' \) | sort
+    fi
+}
+
+# Prints the full path of every wallpaper directly inside directory $1, sorted.
+list_wallpapers_in() {
+    if command -v fd &> /dev/null; then
+        fd . "$1" --max-depth 1 -e png -e jpg -e jpeg -e gif -e webp --type f | sort
+    else
+        find "$1" -maxdepth 1 -type f \( -iname '*.png' -o -iname '*.jpeg' -o -iname '*.jpg' -o -iname '*.gif' -o -iname '*.webp' \) | sort
+    fi
+}
+
+# Prints the wallpapers one directory at a time, each directory sorted. Only
+# the (short) list of directories is sorted as a whole, so the first paths go
+# out as soon as the first directory is read instead of after the whole tree.
+stream_wallpapers() {
+    {
+        printf '%s\n' "$WALLPAPER_DIR"
+        if command -v fd &> /dev/null; then
+            fd . "$WALLPAPER_DIR" --type d
+        else
+            find "$WALLPAPER_DIR" -mindepth 1 -type d
+        fi
+    } | sort | while IFS= read -r dir; do
+        list_wallpapers_in "${dir%/}"
+    done
+}
+
 # --- Startup Mode ---
 # This checks the first argument specifically.
 if [[ "$1" == "--startup" ]]; then
@@ -866,7 +919,19 @@ if [[ "$1" == "--startup" ]]; then
         echo "Error: Failed to start swww-daemon on startup." >&2
         exit 1
     fi
-    echo "swww-daemon is running. Startup script finished."
+    echo "swww-daemon is running."
+    # Fill the selector's thumbnail cache in the background, at low priority,
+    # so the first interactive run after login doesn't decode every wallpaper.
+    if [ -d "$WALLPAPER_DIR" ]; then
+        {
+            build_selector
+            if selector_can_warm_cache; then
+                list_wallpapers | nice -n 19 "$SELECTOR_PATH" --warm-cache
+            fi
+        } > /dev/null 2>&1 &
+        disown
+    fi
+    echo "Startup script finished."
     exit 0
 fi
 
@@ -882,22 +947,15 @@ if [ ! -d "$WALLPAPER_DIR" ]; then
     exit 1
 fi
 
-# --- Get Wallpaper List ---
-if command -v fd &> /dev/null; then
-    WALLPAPER_FILES=$(fd . "$WALLPAPER_DIR" -e png -e jpg -e jpeg -e gif -e webp --type f | sort)
-else
-    WALLPAPER_FILES=$(find "$WALLPAPER_DIR" -type f \( -iname '*.png' -o -iname '*.jpeg' -o -iname '*.jpg' -o -iname '*.gif' -o -iname '*.webp' \) | sort)
-fi
-
-if [ -z "$WALLPAPER_FILES" ]; then
-    send_notification "Wallpaper Script Error" "No image files found in $WALLPAPER_DIR."
-    exit 1
-fi
-
 # --- Cycling Mode (--next/--prev) ---
 # This robustly checks if --next or --prev exists anywhere in the arguments
 if [[ " $@ " =~ " --next " ]] || [[ " $@ " =~ " --prev " ]]; then
     echo "Cycling mode: Finding next/previous wallpaper."
+    WALLPAPER_FILES=$(list_wallpapers)
+    if [ -z "$WALLPAPER_FILES" ]; then
+        send_notification "Wallpaper Script Error" "No image files found in $WALLPAPER_DIR."
+        exit 1
+    fi
     mapfile -t wallpaper_array < <(echo "$WALLPAPER_FILES")
     count=${#wallpaper_array[@]}
     current_wallpaper=$(swww query | head -n 1 | sed 's/.*: //')
@@ -925,15 +983,17 @@ fi
 # --- Interactive Mode (using local cachy-selector) ---
 echo "Interactive mode: Selecting new wallpaper with cachy-selector."
 
-# The path to our custom selector, located in the same directory as this script.
-# This is the robust way to call it, no matter where you run wallpaper.sh from.
-SELECTOR_PATH="$(dirname "$0")/cachy-selector"
-
 # We pipe the list of FULL PATHS directly into our app running in 'dmenu' mode.
-# It will print the selected full path back to us.
-SELECTED_NEW_WALLPAPER_PATH=$(echo "$WALLPAPER_FILES" | "$SELECTOR_PATH" dmenu)
+# It will print the selected full path back to us. The app shows paths as they
+# arrive, and stream_wallpapers hands them over a directory at a time, so the
+# first previews are up while the rest of the folder is still being listed.
+SELECTED_NEW_WALLPAPER_PATH=$(stream_wallpapers | "$SELECTOR_PATH" dmenu)
 
 if [ -z "$SELECTED_NEW_WALLPAPER_PATH" ]; then
+    if [ -z "$(list_wallpapers)" ]; then
+        send_notification "Wallpaper Script Error" "No image files found in $WALLPAPER_DIR."
+        exit 1
+    fi
     echo "No wallpaper selected."
     exit 0
 fi
@@ -2,11 +2,11 @@
 
 LAUNCHER_DIR="$HOME/dotfiles/.config/hypr/C-widgets/archlauncher-c"
 LAUNCHER_BIN="$LAUNCHER_DIR/my-launcher"
-LAUNCHER_NAME="my-launcher"
 
-if pgrep -x "$LAUNCHER_NAME" > /dev/null; then
-    pkill -x "$LAUNCHER_NAME"
-else
+# Ask the resident launcher to show or hide itself. If it is not running yet,
+# start it; it stays in the background from then on. Any arguments (a mode such
+# as "run" or "windows") are passed on.
+if ! "$LAUNCHER_BIN" --toggle "$@" 2> /dev/null; then
     cd "$LAUNCHER_DIR" || exit
-    "$LAUNCHER_BIN" --no-icons &
+    "$LAUNCHER_BIN" --daemon --show "$@" &
 fi